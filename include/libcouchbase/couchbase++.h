@@ -14,8 +14,16 @@
 #include <iostream>
 #include <functional>
 #include <memory>
+#include <iterator>
+#include <random>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
 #include <libcouchbase/couchbase++/forward.h>
 #include <libcouchbase/couchbase++/status.h>
+#include <libcouchbase/couchbase++/memory.h>
+#include <libcouchbase/couchbase++/metrics.h>
+#include <libcouchbase/couchbase++/compression.h>
 
 namespace Couchbase {
 
@@ -115,12 +123,15 @@ template<> inline Command<cmdname>::Scheduler \
 Command<cmdname>::scheduler() const { return schedname; }
 
 LCB_CXX_DECLSCHED(OpInfo::Get, lcb_get3)
+LCB_CXX_DECLSCHED(OpInfo::GetReplica, lcb_rget3)
 LCB_CXX_DECLSCHED(OpInfo::Store, lcb_store3)
 LCB_CXX_DECLSCHED(OpInfo::Touch, lcb_touch3)
 LCB_CXX_DECLSCHED(OpInfo::Remove, lcb_remove3)
 LCB_CXX_DECLSCHED(OpInfo::Stats, lcb_stats3)
 LCB_CXX_DECLSCHED(OpInfo::Unlock, lcb_unlock3)
 LCB_CXX_DECLSCHED(OpInfo::Counter, lcb_counter3)
+LCB_CXX_DECLSCHED(OpInfo::SubdocLookup, lcb_subdoc3)
+LCB_CXX_DECLSCHED(OpInfo::SubdocMutate, lcb_subdoc3)
 
 #define LCB_CXX_CMD_CTOR(name) \
     name() : Command() {} \
@@ -141,6 +152,31 @@ public:
     Scheduler scheduler() const { return lcb_get3; }
 };
 
+//! Which replicas a @ref GetReplicaCommand reads from
+enum class ReplicaMode {
+    //! Query each replica in turn, until one returns the item
+    FIRST = LCB_REPLICA_FIRST,
+    //! Query all replicas at once, returning each of their responses
+    ALL = LCB_REPLICA_ALL,
+    //! Query a single replica, given by GetReplicaCommand::index()
+    SELECT = LCB_REPLICA_SELECT
+};
+
+//! @brief Command structure for retrieving items from replica nodes
+//! @details
+//! Replicas are updated asynchronously, so the value may be older than the
+//! one on the active node.
+//! @see Client::get_replica()
+class GetReplicaCommand : public Command<OpInfo::GetReplica> {
+public:
+    LCB_CXX_CMD_CTOR(GetReplicaCommand)
+    void mode(ReplicaMode m) { m_cmd.strategy = static_cast<lcb_replica_t>(m); }
+    ReplicaMode mode() const { return static_cast<ReplicaMode>(m_cmd.strategy); }
+    //! Read from a specific replica. This implies ReplicaMode::SELECT
+    //! @param ix the replica number, starting at 0
+    void index(int ix) { mode(ReplicaMode::SELECT); m_cmd.index = ix; }
+};
+
 //! @brief Command structure for mutating/storing items
 template <StoreMode M>
 class StoreCommand : public Command<OpInfo::Store> {
@@ -179,6 +215,19 @@ public:
     //!          Ensure to comply with these rules if inter-operability with
     //!          them is important.
     void itemflags(uint32_t f) { m_cmd.flags = f; }
+
+    //! @brief Mark the value as already compressed with Snappy
+    //! @details
+    //! The value is sent as it is, flagged as compressed, and the library
+    //! does not compress it again. See Client::compression() to have the
+    //! library compress values instead.
+    void compressed(bool enabled = true) {
+        if (enabled) {
+            m_cmd.datatype |= LCB_VALUE_F_SNAPPYCOMP;
+        } else {
+            m_cmd.datatype &= ~LCB_VALUE_F_SNAPPYCOMP;
+        }
+    }
 };
 
 typedef StoreCommand<LCB_SET> UpsertCommand;
@@ -232,6 +281,198 @@ public:
     LCB_CXX_CMD_CTOR(UnlockCommand)
 };
 
+namespace Internal {
+//! @private
+//! Common storage for the paths of a sub-document command. The command
+//! points to the spec array, so copies re-point it to their own.
+template <typename T>
+class SubdocCommand : public Command<T> {
+public:
+    SubdocCommand(const SubdocCommand& other)
+    : Command<T>(other), m_specs(other.m_specs), m_owned(other.m_owned) {
+        sync();
+    }
+    SubdocCommand& operator=(const SubdocCommand& other) {
+        Command<T>::operator=(other);
+        m_specs = other.m_specs;
+        m_owned = other.m_owned;
+        sync();
+        return *this;
+    }
+
+    //! Number of paths in the command
+    size_t size() const { return m_specs.size(); }
+
+protected:
+    SubdocCommand() : Command<T>() {}
+
+    void add_spec(lcb_SUBDOCOP op, const char *path, size_t npath,
+        const char *value, size_t nvalue, uint32_t options = 0) {
+        lcb_SDSPEC spec;
+        memset(&spec, 0, sizeof spec);
+        spec.sdcmd = op;
+        spec.options = options;
+        LCB_SDSPEC_SET_PATH(&spec, path, npath);
+        if (value != NULL) {
+            LCB_SDSPEC_SET_VALUE(&spec, value, nvalue);
+        }
+        m_specs.push_back(spec);
+        sync();
+    }
+
+    //! Keep a copy of a path or value, for as long as any copy of the command
+    const std::string& own(std::string&& s) {
+        m_owned.push_back(std::make_shared<std::string>(std::move(s)));
+        return *m_owned.back();
+    }
+
+private:
+    void sync() {
+        this->m_cmd.specs = m_specs.data();
+        this->m_cmd.nspecs = m_specs.size();
+    }
+    std::vector<lcb_SDSPEC> m_specs;
+    // Shared between copies, so spec values pointing into them stay valid
+    std::vector<std::shared_ptr<std::string>> m_owned;
+};
+}
+
+//! @brief Command to read parts of a document
+//! @details
+//! Each path is looked up on the server and only the matching fragments
+//! of the document are returned. Paths use N1QL syntax (e.g.
+//! `address.city` or `tags[0]`). Paths passed as `std::string` are copied
+//! into the command; those passed as a buffer and length must remain valid
+//! until the command has been scheduled, as with keys.
+//!
+//! @code{c++}
+//! LookupInCommand cmd("user::42");
+//! cmd.get("name").exists("banned");
+//! LookupInResponse resp = client.lookup_in(cmd);
+//! if (resp.status(0)) {
+//!     std::cout << resp.value(0) << std::endl;
+//! }
+//! @endcode
+class LookupInCommand : public Internal::SubdocCommand<OpInfo::SubdocLookup> {
+public:
+    LookupInCommand() {}
+    LookupInCommand(const char *k) { key(k); }
+    LookupInCommand(const char *k, size_t n) { key(k, n); }
+    LookupInCommand(const std::string& s) { key(s); }
+
+    //! Get the value at a path
+    LookupInCommand& get(const char *path, size_t npath) {
+        add_spec(LCB_SDCMD_GET, path, npath, NULL, 0);
+        return *this;
+    }
+    LookupInCommand& get(const std::string& path) {
+        const std::string& p = own(std::string(path));
+        return get(p.c_str(), p.size());
+    }
+
+    //! Check whether a path exists, without returning its value
+    LookupInCommand& exists(const char *path, size_t npath) {
+        add_spec(LCB_SDCMD_EXISTS, path, npath, NULL, 0);
+        return *this;
+    }
+    LookupInCommand& exists(const std::string& path) {
+        const std::string& p = own(std::string(path));
+        return exists(p.c_str(), p.size());
+    }
+
+    //! Get the number of elements in the array or object at a path
+    LookupInCommand& get_count(const char *path, size_t npath) {
+        add_spec(LCB_SDCMD_GET_COUNT, path, npath, NULL, 0);
+        return *this;
+    }
+    LookupInCommand& get_count(const std::string& path) {
+        const std::string& p = own(std::string(path));
+        return get_count(p.c_str(), p.size());
+    }
+};
+
+//! @brief Command to modify parts of a document
+//! @details
+//! All mutations are applied atomically: either every path is modified, or
+//! none is. Values must be valid JSON (strings must be quoted). Paths and
+//! values are copied into the command.
+//!
+//! @code{c++}
+//! MutateInCommand cmd("user::42");
+//! cmd.upsert("address.city", "\"Paris\"", true).counter("logins", 1);
+//! MutateInResponse resp = client.mutate_in(cmd);
+//! @endcode
+class MutateInCommand : public Internal::SubdocCommand<OpInfo::SubdocMutate> {
+public:
+    MutateInCommand() {}
+    MutateInCommand(const char *k) { key(k); }
+    MutateInCommand(const char *k, size_t n) { key(k, n); }
+    MutateInCommand(const std::string& s) { key(s); }
+
+    //! Create the document if it does not exist
+    void create_document(bool enabled = true) {
+        if (enabled) {
+            m_cmd.cmdflags |= LCB_CMDSUBDOC_F_UPSERT_DOC;
+        } else {
+            m_cmd.cmdflags &= ~static_cast<uint32_t>(LCB_CMDSUBDOC_F_UPSERT_DOC);
+        }
+    }
+
+    //! Set the value at a path, replacing any existing value
+    //! @param create_parents create any missing objects along the path
+    MutateInCommand& upsert(const std::string& path, const std::string& value, bool create_parents = false) {
+        return add(LCB_SDCMD_DICT_UPSERT, path, value, create_parents);
+    }
+    //! Set the value at a path, which must not already exist
+    MutateInCommand& insert(const std::string& path, const std::string& value, bool create_parents = false) {
+        return add(LCB_SDCMD_DICT_ADD, path, value, create_parents);
+    }
+    //! Replace the value at a path, which must already exist
+    MutateInCommand& replace(const std::string& path, const std::string& value) {
+        return add(LCB_SDCMD_REPLACE, path, value, false);
+    }
+    //! Remove the value at a path
+    MutateInCommand& remove(const std::string& path) {
+        const std::string& p = own(std::string(path));
+        add_spec(LCB_SDCMD_REMOVE, p.c_str(), p.size(), NULL, 0);
+        return *this;
+    }
+    //! Add a value to the end of the array at a path
+    MutateInCommand& array_append(const std::string& path, const std::string& value, bool create_parents = false) {
+        return add(LCB_SDCMD_ARRAY_ADD_LAST, path, value, create_parents);
+    }
+    //! Add a value to the start of the array at a path
+    MutateInCommand& array_prepend(const std::string& path, const std::string& value, bool create_parents = false) {
+        return add(LCB_SDCMD_ARRAY_ADD_FIRST, path, value, create_parents);
+    }
+    //! Insert a value into an array. The path ends with the index, e.g. `tags[2]`
+    MutateInCommand& array_insert(const std::string& path, const std::string& value) {
+        return add(LCB_SDCMD_ARRAY_INSERT, path, value, false);
+    }
+    //! Add a value to the array at a path, unless it is already present
+    MutateInCommand& array_add_unique(const std::string& path, const std::string& value, bool create_parents = false) {
+        return add(LCB_SDCMD_ARRAY_ADD_UNIQUE, path, value, create_parents);
+    }
+    //! Add `delta` to the number at a path. The new value is returned in the
+    //! response
+    MutateInCommand& counter(const std::string& path, int64_t delta, bool create_parents = false) {
+        const std::string& p = own(std::string(path));
+        const std::string& v = own(std::to_string(delta));
+        add_spec(LCB_SDCMD_COUNTER, p.c_str(), p.size(), v.c_str(), v.size(),
+            create_parents ? LCB_SDSPEC_F_MKINTERMEDIATES : 0);
+        return *this;
+    }
+
+private:
+    MutateInCommand& add(lcb_SUBDOCOP op, const std::string& path, const std::string& value, bool create_parents) {
+        const std::string& p = own(std::string(path));
+        const std::string& v = own(std::string(value));
+        add_spec(op, p.c_str(), p.size(), v.c_str(), v.size(),
+            create_parents ? LCB_SDSPEC_F_MKINTERMEDIATES : 0);
+        return *this;
+    }
+};
+
 //! Command to retrieve persistence/replication metadata for an item
 class ObserveCommand : public Command<OpInfo::Observe> {
 public:
@@ -245,6 +486,25 @@ public:
     }
 };
 
+//! @brief Identifies a mutation by its vBucket, the vBucket's UUID and the
+//! sequence number assigned to it.
+//! @details
+//! Tokens are returned with mutations only if the client was created with
+//! `fetch_mutation_tokens=true` in its connection string.
+class MutationToken : public lcb_MUTATION_TOKEN {
+public:
+    MutationToken() {
+        memset(static_cast<lcb_MUTATION_TOKEN*>(this), 0, sizeof(lcb_MUTATION_TOKEN));
+    }
+    MutationToken(const lcb_MUTATION_TOKEN& token) : lcb_MUTATION_TOKEN(token) {}
+
+    uint64_t uuid() const { return LCB_MUTATION_TOKEN_ID(this); }
+    uint64_t seqno() const { return LCB_MUTATION_TOKEN_SEQ(this); }
+    uint16_t vbid() const { return LCB_MUTATION_TOKEN_VB(this); }
+    //! Whether the token was returned by the server
+    bool valid() const { return LCB_MUTATION_TOKEN_ISVALID(this); }
+};
+
 //! Command to ensure persistence/replication of an item to a number of nodes.
 //! @see DurabilityOptions
 class EndureCommand : public Command<OpInfo::Endure> {
@@ -261,6 +521,15 @@ public:
     const DurabilityOptions* options() const { return m_options; }
     void options(const DurabilityOptions *o) { m_options = o; }
 
+    //! @brief Set the token of the mutation to check
+    //! @details
+    //! This is used when the options select DurabilityMode::SEQNO. If not
+    //! set, the most recent token seen by the client for the key's vBucket
+    //! is used.
+    //! @param token the token. It is copied when the command is scheduled,
+    //!        and must remain valid until then
+    void mutation_token(const MutationToken *token) { m_cmd.mutation_token = token; }
+
 private:
     const DurabilityOptions *m_options = NULL;
 };
@@ -282,6 +551,19 @@ enum class ReplicateTo : lcb_U16 {
     THREE = 3 //!< Wait for replication to three replicas
 };
 
+//! How durability is checked
+enum class DurabilityMode : lcb_U8 {
+    //! Use sequence numbers if the mutation has a token, otherwise CAS
+    DEFAULT = LCB_DURABILITY_MODE_DEFAULT,
+    //! Poll with `OBSERVE`, comparing the item's CAS on each node
+    CAS = LCB_DURABILITY_MODE_CAS,
+    //! Poll with `OBSERVE_SEQNO`, comparing the mutation's sequence number
+    //! with each node's persisted and replicated sequence numbers. Each
+    //! probe is per vBucket rather than per item, and is unaffected by later
+    //! mutations of the same item. Requires a MutationToken
+    SEQNO = LCB_DURABILITY_MODE_SEQNO
+};
+
 //! Options for durability constraints
 class DurabilityOptions : public lcb_durability_opts_t {
 public:
@@ -315,11 +597,106 @@ public:
     //! @param enabled whether to enable this behavioe
     void cap_max(bool enabled) { v.v0.cap_max = enabled; }
 
+    //! Select how durability is checked
+    void mode(DurabilityMode m) { v.v0.pollopts = static_cast<lcb_U8>(m); }
+    DurabilityMode mode() const { return static_cast<DurabilityMode>(v.v0.pollopts); }
+
     bool enabled() const {
         return v.v0.persist_to || v.v0.replicate_to;
     }
 };
 
+//! @brief Policy for retrying operations which fail with a temporary error
+//! @details
+//! When a key/value operation is rejected by the server with a temporary
+//! error (`LCB_ETMPFAIL`, `LCB_EBUSY` or `LCB_ENOMEM`), it is rescheduled
+//! after a delay, from within the event loop. The delay grows exponentially
+//! with each attempt and is randomized ("jittered") so that many clients
+//! backing off at once do not retry in lockstep.
+//!
+//! Other temporary errors, such as timeouts and network failures, leave it
+//! unknown whether the server applied the operation. Only gets (other than
+//! get-and-lock) and unconditional upserts (without a CAS) are retried after
+//! these, since applying them twice has the same effect as applying them
+//! once.
+//!
+//! Retries are disabled by default; see Client::retry_policy().
+class RetryPolicy {
+public:
+    //! @param max_attempts the maximum number of times an operation is
+    //!        sent, including the first. 0 or 1 disables retries
+    //! @param initial_delay the base delay before the first retry, in
+    //!        microseconds
+    //! @param max_delay the maximum delay between attempts, in microseconds
+    //! @param deadline the time, from when the operation was first scheduled,
+    //!        after which no more retries are attempted, in microseconds
+    RetryPolicy(unsigned max_attempts = 0, uint32_t initial_delay = 1000,
+        uint32_t max_delay = 500000, uint32_t deadline = 2500000)
+    : m_attempts(max_attempts), m_initial(initial_delay),
+      m_max(max_delay), m_deadline(deadline) {}
+
+    void max_attempts(unsigned n) { m_attempts = n; }
+    void initial_delay(uint32_t usec) { m_initial = usec; }
+    void max_delay(uint32_t usec) { m_max = usec; }
+    void deadline(uint32_t usec) { m_deadline = usec; }
+
+    unsigned max_attempts() const { return m_attempts; }
+    uint32_t deadline() const { return m_deadline; }
+    bool enabled() const { return m_attempts > 1; }
+
+    //! Get the delay before a given retry
+    //! @param attempt the number of attempts made so far (at least 1)
+    //! @param rand a random number, used for jitter
+    //! @return a delay in microseconds, between half of and the full
+    //!         exponential delay for this attempt
+    uint32_t delay(unsigned attempt, uint32_t rand) const {
+        uint64_t d = m_initial;
+        for (unsigned ii = 1; ii < attempt && d < m_max; ii++) {
+            d *= 2;
+        }
+        if (d > m_max) {
+            d = m_max;
+        }
+        return static_cast<uint32_t>(d / 2 + (d / 2 ? rand % (d / 2 + 1) : 0));
+    }
+
+private:
+    unsigned m_attempts;
+    uint32_t m_initial;
+    uint32_t m_max;
+    uint32_t m_deadline;
+};
+
+//! Counters for automatic retries. See Client::retry_stats()
+struct RetryStats {
+    //! Number of times an operation was rescheduled
+    size_t retries = 0;
+    //! Number of operations which succeeded after being retried
+    size_t recovered = 0;
+    //! Number of operations which failed with a temporary error, but were
+    //! not retried further because the attempts or deadline were exhausted
+    size_t exhausted = 0;
+};
+
+namespace Internal {
+template <typename T> class RetryOp;
+class GetFlight;
+class DurGroup;
+class HedgedGet;
+
+//! @private
+//! Part of an operation scheduled within the current scheduling scope (see
+//! Client::enter()), which is undone if the scope is failed rather than
+//! left, since the library then drops the operation
+struct Unschedule {
+    enum Kind { TIMED, RETRY, FLIGHT, WAITER };
+    Kind kind;
+    //! The wrapper (TIMED, RETRY) or attached handler (WAITER)
+    Handler *handler;
+    GetFlight *flight;
+};
+}
+
 class Client;
 
 //! Base handler class for handling/converting responses.
@@ -338,6 +715,15 @@ public:
     //! Indicate whether this is the final command for the request
     //! @return true if done
     virtual bool done() const = 0;
+
+    //! Called once #done() has returned true and the client has finished
+    //! its own bookkeeping for the request. The client does not access the
+    //! handler afterwards, so the handler may destroy itself from here.
+    //! @note This may run while the client is still dispatching other
+    //!       responses (e.g. those of coalesced gets). Work which could
+    //!       schedule operations or destroy other handlers should be deferred
+    //!       with Client::_defer()
+    virtual void finish() {}
     virtual ~Handler() {}
     Handler* as_cookie() { return this; }
 };
@@ -361,7 +747,7 @@ public:
     //! @return the CAS.
     uint64_t cas() const { return u.base.cas; }
 
-    Response() {}
+    Response() { memset(&u, 0, sizeof u); }
     virtual ~Response() {}
 
     //! @private
@@ -406,31 +792,121 @@ namespace Internal {
 typedef Response<OpInfo::Base> BaseResponse;
 }
 
-typedef Response<OpInfo::Store> StoreResponse;
-typedef Response<OpInfo::Remove> RemoveResponse;
+//! @brief Response for an operation which modifies an item
+//! @details
+//! In addition to the CAS, this carries the mutation's token, if the
+//! server returned one.
+template <typename T>
+class MutationResponse : public Response<T> {
+public:
+    //! @private
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *res) override {
+        Response<T>::handle_response(client, cbtype, res);
+        const lcb_MUTATION_TOKEN *token = NULL;
+        if (res->rc == LCB_SUCCESS) {
+            token = lcb_resp_get_mutation_token(cbtype, res);
+        }
+        m_token = token ? MutationToken(*token) : MutationToken();
+    }
+
+    //! Get the token of the mutation. Only valid if the operation
+    //! succeeded and the client fetches mutation tokens
+    const MutationToken& mutation_token() const { return m_token; }
+
+private:
+    MutationToken m_token;
+};
+
+namespace Internal {
+template <typename T> inline const MutationToken *token_of(const Response<T>&) { return NULL; }
+template <typename T> inline const MutationToken *token_of(const MutationResponse<T>& resp) {
+    return resp.mutation_token().valid() ? &resp.mutation_token() : NULL;
+}
+}
+
+typedef MutationResponse<OpInfo::Store> StoreResponse;
+typedef MutationResponse<OpInfo::Remove> RemoveResponse;
 typedef Response<OpInfo::Touch> TouchResponse;
 typedef Response<OpInfo::Unlock> UnlockResponse;
 
+//! @brief Reference-counted handle to the value of a @ref GetResponse
+//! @details
+//! A SharedValue keeps the value alive independently of the response it was
+//! obtained from (see GetResponse::shared_value()). Copying a SharedValue
+//! does not copy the value itself.
+//!
+//! @warning If the value still refers to the library's network buffer
+//! (i.e. GetResponse::detatch() was not called) then the handle must only be
+//! copied and destroyed on the thread running the client.
+class SharedValue {
+public:
+    SharedValue() {}
+    inline SharedValue(const SharedValue&);
+    inline SharedValue(SharedValue&&);
+    inline SharedValue& operator=(const SharedValue&);
+    inline SharedValue& operator=(SharedValue&&);
+    ~SharedValue() { clear(); }
+
+    const char *data() const { return m_value.data(); }
+    size_t size() const { return m_value.size(); }
+    bool empty() const { return m_value.empty(); }
+    const Buffer& buffer() const { return m_value; }
+    operator const Buffer&() const { return m_value; }
+    std::string to_string() const { return m_value.to_string(); }
+
+    //! Drop the reference to the value
+    inline void clear();
+
+private:
+    friend class GetResponse;
+    Buffer m_value;
+    lcb_BACKBUF m_bufh = NULL;
+    std::shared_ptr<const char> m_owned;
+};
+
 //! @brief Response for @ref GetCommand requests
+//! @details
+//! The value is not copied out of the network buffer it was received in;
+//! the response holds a reference on that buffer until it is destroyed or
+//! #clear() is called. Responses are move-only: use #shared_value() to keep
+//! a reference to the value from more than one place.
 class GetResponse : public Response<OpInfo::Get> {
 public:
     inline GetResponse();
-    GetResponse(const GetResponse& other) { assign_first(other); }
-    inline GetResponse& operator=(const GetResponse&);
+    inline GetResponse(GetResponse&& other);
+    inline GetResponse& operator=(GetResponse&&);
 
     ~GetResponse() { clear(); }
 
     //! @brief Release memory used by the response value
     inline void clear();
 
+    //! @brief Make the value owned by the response itself.
+    //! By default the value refers to the library's network buffer. Call
+    //! this before handing the response to another thread, as the library's
+    //! buffers may not be released outside the thread running the client.
+    //! This copies the value.
+    inline void detatch();
+
     //! Get the value for the item
     //! @return a buffer holding the value of the buffer. This buffer is valid
     //!         until the response is destroyed or the ::clear() function is
     //!         explicitly called.
-    const char* valuebuf() const { return (const char *)u.resp.value; }
+    //! @note If the value was received compressed and the client has a
+    //!       Decompressor, it is decompressed by the first call to this (or
+    //!       any other accessor of the value)
+    const char* valuebuf() const { return plain().data(); }
 
     //! Gets the length of the value
-    size_t valuesize() const { return u.resp.nvalue; }
+    size_t valuesize() const { return plain().size(); }
+
+    //! Whether the value is (still) compressed. This is the case if it was
+    //! received compressed and either has not been accessed yet, or the
+    //! client has no Decompressor
+    bool compressed() const {
+        return (u.resp.datatype & LCB_VALUE_F_SNAPPYCOMP) &&
+                !(m_inflation && m_inflation->inflated());
+    }
 
     //! Copies the contents of the value into a std::string
     inline void value(std::string& s) const;
@@ -440,21 +916,48 @@ public:
 
     Buffer value() const { return Buffer(valuebuf(), valuesize()); }
 
+    //! @brief Get a reference-counted handle to the value.
+    //! The handle remains valid after this response is destroyed. No copy
+    //! of the value is made.
+    inline SharedValue shared_value() const;
+
     //! Get the flags of the item. See StoreCommand::itemflags
     uint32_t valueflags() const { return u.resp.itmflags; }
     uint32_t itemflags() const { return valueflags(); }
 
+    //! Whether the response was read from a replica rather than the active
+    //! node
+    bool from_replica() const { return m_replica; }
+
     //! @private
     inline void handle_response(Client&, int, const lcb_RESPBASE *) override;
 
 private:
     friend class Client;
     friend class ViewRow;
-    inline void assign_first(const GetResponse& other);
+    friend class ReadCache;
+    GetResponse(const GetResponse&) = delete;
+    GetResponse& operator=(const GetResponse&) = delete;
+    inline void assign_shared(const GetResponse& other);
+    inline void assign_move(GetResponse& other);
 
     inline bool has_shared_buffer() const;
-    inline bool has_alloc_buffer() const;
-    inline char *vbuf_refcnt();
+    inline Buffer plain() const;
+    //! Memory held for the value: the value as received (which may be
+    //! compressed), plus the size of its decompressed copy. As that copy is
+    //! shared with (and may be made by) any copy of the response, it is
+    //! counted whether or not it has been made yet. Unlike #valuesize() this
+    //! never decompresses the value
+    size_t footprint() const {
+        return u.resp.nvalue + (m_inflation ? m_inflation->size() : 0);
+    }
+
+    // Holds the value if it is not backed by a library buffer
+    std::shared_ptr<const char> m_owned;
+    MemoryResource *m_resource = NULL;
+    bool m_replica = false;
+    // Set if the value is compressed and the client has a Decompressor
+    std::shared_ptr<Internal::Inflation> m_inflation;
 };
 
 class StatsResponse : public Response<OpInfo::Stats> {
@@ -468,18 +971,123 @@ private:
     bool m_done = false;
 };
 
-class CounterResponse : public Response<OpInfo::Counter> {
+class CounterResponse : public MutationResponse<OpInfo::Counter> {
 public:
-    void handle_response(Client&, int, const lcb_RESPBASE *res) override {
-        u.resp = *(lcb_RESPCOUNTER *)res;
-    }
-
     //! Get the current counter value
     //! @returns the current counter value. This is the value after the
     //!          counter operation. Only valid if the operation succeeded.
     uint64_t value() const { return u.resp.value; }
 };
 
+namespace Internal {
+//! @private
+//! Per-path results of a sub-document response. The values refer to the
+//! library's network buffer, on which a reference is held.
+class SubdocResults {
+public:
+    SubdocResults() {}
+    SubdocResults(const SubdocResults& other) { assign(other); }
+    SubdocResults(SubdocResults&& other) { take(other); }
+    SubdocResults& operator=(const SubdocResults& other) {
+        if (this != &other) {
+            clear();
+            assign(other);
+        }
+        return *this;
+    }
+    SubdocResults& operator=(SubdocResults&& other) {
+        if (this != &other) {
+            clear();
+            take(other);
+        }
+        return *this;
+    }
+    ~SubdocResults() { clear(); }
+
+    inline void load(lcb_RESPSUBDOC *resp);
+    inline void clear();
+
+    //! Set the number of paths in the command
+    void expect(size_t nspecs) { m_nspecs = nspecs; }
+
+    size_t size() const { return m_entries.size(); }
+    Buffer value(size_t ix) const { return ix < size() ? m_entries[ix].value : Buffer(); }
+    Status status(size_t ix) const {
+        if (ix < size()) {
+            return m_entries[ix].status;
+        }
+        // A successful mutation only has entries for paths with a value
+        return m_success && ix < m_nspecs ? Status() : Status(LCB_EINVAL);
+    }
+
+private:
+    struct Entry {
+        Buffer value;
+        Status status;
+    };
+    inline void assign(const SubdocResults& other);
+    inline void take(SubdocResults& other);
+    std::vector<Entry> m_entries;
+    lcb_BACKBUF m_bufh = NULL;
+    size_t m_nspecs = 0;
+    bool m_success = false;
+};
+}
+
+//! @brief Response for a @ref LookupInCommand
+//! @details
+//! Results are indexed in the order the paths were added to the command.
+//! Values are the raw JSON fragments, referring to the library's network
+//! buffer; nothing is copied.
+class LookupInResponse : public Response<OpInfo::SubdocLookup> {
+public:
+    //! @private
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *res) override {
+        Response::handle_response(client, cbtype, res);
+        m_results.load(&u.resp);
+    }
+
+    //! Number of path results
+    size_t size() const { return m_results.size(); }
+    //! Get the value found at a path
+    Buffer value(size_t ix) const { return m_results.value(ix); }
+    //! Get the status for a path. Check this rather than #status(), which
+    //! reports `LCB_SUBDOC_MULTI_FAILURE` if any path was not found
+    Status status(size_t ix) const { return m_results.status(ix); }
+    Status status() const { return Response::status(); }
+    //! Whether a path exists
+    bool exists(size_t ix) const { return status(ix).success(); }
+
+private:
+    friend class Client;
+    Internal::SubdocResults m_results;
+};
+
+//! @brief Response for a @ref MutateInCommand
+//! @details
+//! The status of the command as a whole is #status(). Only some mutations
+//! (e.g. counters) return a value; these are indexed in the order the paths
+//! were added to the command. If a path failed, its status is set and
+//! #status() is `LCB_SUBDOC_MULTI_FAILURE`. When the response comes from
+//! Client::mutate_in(), every path of a successful command reports success.
+class MutateInResponse : public MutationResponse<OpInfo::SubdocMutate> {
+public:
+    //! @private
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *res) override {
+        MutationResponse::handle_response(client, cbtype, res);
+        m_results.load(&u.resp);
+    }
+
+    size_t size() const { return m_results.size(); }
+    Buffer value(size_t ix) const { return m_results.value(ix); }
+    Status status(size_t ix) const { return m_results.status(ix); }
+    Status status() const { return MutationResponse::status(); }
+
+private:
+    friend class Client;
+    Internal::SubdocResults m_results;
+};
+
 class ObserveResponse : public Response<OpInfo::Observe> {
 public:
     struct ServerReply {
@@ -531,13 +1139,40 @@ public:
     size_t replicate() const { return u.resp.nreplicated; }
 };
 
-//! Response object wrapping a durable operation.
+//! @brief Response object wrapping a durable operation.
+//! @details
+//! Once the mutation itself succeeds, its durability check is queued with
+//! the client rather than started on its own. Checks queued within the
+//! client's durability window (see Client::durability_window()) are
+//! submitted together, so many keys share the same `OBSERVE` polling rounds.
+//!
+//! @code{c++}
+//! DurabilityOptions opts(PersistTo::MASTER, ReplicateTo::ONE);
+//! std::vector<DurableResponse<StoreResponse>> resps(keys.size(), &opts);
+//! Context ctx(client);
+//! for (size_t ii = 0; ii < keys.size(); ii++) {
+//!     ctx.add(UpsertCommand(keys[ii], value), &resps[ii]);
+//! }
+//! ctx.submit();
+//! client.wait();
+//! @endcode
 template<typename T>
 class DurableResponse : public Handler {
 public:
     inline void handle_response(Client&, int, const lcb_RESPBASE*) override;
     inline bool done() const override;
+    //! @param options the durability requirements. These must remain valid
+    //!        until the operation completes
     DurableResponse(const DurabilityOptions *options) : m_duropt(options){}
+
+    //! The response for the mutation itself
+    const T& operation() const { return m_op; }
+    //! The response for the durability check. If the mutation failed, this
+    //! carries its error
+    const EndureResponse& durability() const { return m_dur; }
+    //! @return the status of the durability check, or of the mutation if it
+    //!         failed
+    Status status() const { return m_dur.status(); }
 private:
     inline void dur_bail(Status&);
     const DurabilityOptions *m_duropt;
@@ -553,7 +1188,7 @@ template <typename T>
 class MultiContextT {
 public:
     inline MultiContextT();
-    inline MultiContextT(lcb_MULTICMD_CTX*, Handler*, Client*);
+    inline MultiContextT(lcb_MULTICMD_CTX*, Handler*, Client*, OpType);
     inline MultiContextT& operator=(MultiContextT&&);
     inline ~MultiContextT();
     inline Status add(const T*);
@@ -563,6 +1198,8 @@ private:
     lcb_MULTICMD_CTX *m_inner;
     Handler *cookie;
     Client *client;
+    OpType m_type = OpType::OBSERVE;
+    size_t m_count = 0;
     MultiContextT(MultiContextT&) = delete;
     MultiContextT& operator=(MultiContextT&) = delete;
 };
@@ -621,7 +1258,7 @@ private:
 template <typename C, typename R>
 class BatchCommand {
 public:
-    typedef std::list<R> RList;
+    typedef std::list<R, Internal::ResourceAllocator<R>> RList;
     inline BatchCommand(Client&);
     inline Status add(const C& cmd);
     template <typename ...Params> Status add(Params... params) {
@@ -638,6 +1275,94 @@ protected:
     RList m_resplist; // List of responses
 };
 
+namespace Internal {
+//! @private
+//! Chunked storage for response objects. Objects never move once created,
+//! so their addresses may be used as operation cookies. Chunks are kept
+//! across #reset() so that a reused arena does not allocate.
+template <typename R>
+class ResponseArena {
+public:
+    class const_iterator {
+    public:
+        const R& operator*() const { return m_arena->at(m_index); }
+        const R* operator->() const { return &m_arena->at(m_index); }
+        const_iterator& operator++() { ++m_index; return *this; }
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+    private:
+        friend class ResponseArena;
+        const_iterator(const ResponseArena *arena, size_t index) : m_arena(arena), m_index(index) {}
+        const ResponseArena *m_arena;
+        size_t m_index;
+    };
+
+    inline ResponseArena(size_t chunksize);
+    inline R& alloc();
+    inline void reserve(size_t n);
+    inline void reset();
+    size_t size() const { return m_used; }
+    const R& at(size_t ix) const { return m_chunks[ix / m_chunksize][ix % m_chunksize]; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_used); }
+
+private:
+    std::vector<std::unique_ptr<R[]>> m_chunks;
+    size_t m_chunksize;
+    size_t m_used = 0;
+};
+}
+
+//! @brief Batch command storing its responses in a reusable arena
+//! @details
+//! This behaves like @ref BatchCommand, but instead of allocating a list node
+//! for each response, responses are placed in contiguous chunks which are
+//! retained when the batch is #reset(). A batch which is reused for batches
+//! of similar sizes thus performs no allocations once warmed up, and
+//! iterating over its responses walks contiguous memory.
+//!
+//! @code{c++}
+//! ArenaBatchCommand<GetCommand, GetResponse> batch(client, 10000);
+//! for (...) {
+//!     for (auto& key : keys) { batch.add(key); }
+//!     batch.submit();
+//!     client.wait();
+//!     for (auto& resp : batch) { ... }
+//!     batch.reset();
+//! }
+//! @endcode
+template <typename C, typename R>
+class ArenaBatchCommand {
+public:
+    typedef typename Internal::ResponseArena<R>::const_iterator const_iterator;
+
+    //! @param client the client
+    //! @param reserve the number of responses to allocate room for up front
+    //! @param chunksize the number of responses in each contiguous chunk
+    inline ArenaBatchCommand(Client& client, size_t reserve = 0, size_t chunksize = 1024);
+    inline Status add(const C& cmd);
+    template <typename ...Params> Status add(Params... params) {
+        return add(C(params...));
+    }
+    Context& context() { return m_ctx; }
+    void submit() { m_ctx.submit(); }
+
+    //! @brief Discard all responses and re-activate the batch.
+    //! This should only be called once all responses have been received,
+    //! i.e. after Client::wait() has returned.
+    inline void reset();
+
+    //! Get the number of commands added to the batch
+    size_t size() const { return m_arena.size(); }
+
+    const_iterator begin() const { return m_arena.begin(); }
+    const_iterator end() const { return m_arena.end(); }
+
+protected:
+    Context m_ctx;
+    Internal::ResponseArena<R> m_arena;
+};
+
 template <typename C, typename R>
 class CallbackCommand : public Handler {
 public:
@@ -689,6 +1414,49 @@ public:
 
     }
 
+    //! @brief Retrieve multiple items at once
+    //! @details
+    //! All keys are scheduled together and sent in a single pipeline, so the
+    //! total latency is roughly that of the slowest key rather than the sum
+    //! of all of them. The keys are not copied.
+    //! @param keys the keys to retrieve
+    //! @return the responses, in the same order as `keys`. Each response's
+    //!         key refers to the corresponding string in `keys`.
+    inline std::vector<GetResponse> get_multi(const std::vector<std::string>& keys);
+
+    //! @brief Retrieve an item from a replica
+    //! @details
+    //! With ReplicaMode::ALL, this returns the first successful response
+    //! (see #get_replicas() to receive all of them).
+    //! @return the response. GetResponse::from_replica() is true
+    inline GetResponse get_replica(const GetReplicaCommand&);
+    template <typename ...Params> GetResponse get_replica(Params... params) {
+        return get_replica(GetReplicaCommand(params...));
+    }
+
+    //! @brief Retrieve an item from replicas, returning every response
+    //! @return one response per replica queried. Usually used with
+    //!         ReplicaMode::ALL
+    inline std::vector<GetResponse> get_replicas(const GetReplicaCommand&);
+
+    //! @brief Retrieve an item, falling back to a replica if the active node
+    //! is slow to respond
+    //! @details
+    //! The get is sent to the active node. If it has not responded within
+    //! `delay` microseconds, or fails with an error other than the item not
+    //! existing, a replica read (ReplicaMode::FIRST) is also sent, and the
+    //! first successful response is returned. Use
+    //! GetResponse::from_replica() to tell which one answered.
+    //!
+    //! The slower response is discarded when it arrives, during a later
+    //! call to #wait(); later operations do not wait for it. Get-and-lock
+    //! commands should not be hedged.
+    //! @param cmd the get
+    //! @param delay how long to wait for the active node before also
+    //!        reading from a replica, in microseconds. A delay around the
+    //!        active node's usual p95-p99 latency keeps the extra reads rare
+    inline GetResponse get_hedged(const GetCommand& cmd, uint32_t delay);
+
     template <lcb_storage_t T> inline StoreResponse store(const StoreCommand<T>&);
 
     template <typename ...Params> StoreResponse upsert(Params... params) {
@@ -701,6 +1469,31 @@ public:
         return store(ReplaceCommand(params...));
     }
 
+    //! @brief Store multiple items at once
+    //! @details
+    //! Each element of the range is a pair-like object whose `first` and
+    //! `second` members are the key and value (for example a
+    //! `std::map<std::string, std::string>` or a vector of pairs).
+    //! The library copies keys and values into its packet buffers while
+    //! scheduling, before this function waits for the responses. The input
+    //! therefore need only live for the duration of the call, and is never
+    //! staged or copied in between.
+    //! @param begin start of the range
+    //! @param end end of the range. The range must be traversable more
+    //!        than once (i.e. forward iterators)
+    //! @return the responses, in the same order as the input. Each
+    //!         response's key refers to the corresponding input key.
+    template <StoreMode M = LCB_SET, typename Iter>
+    inline std::vector<StoreResponse> store_multi(Iter begin, Iter end);
+    template <typename Iter>
+    std::vector<StoreResponse> upsert_multi(Iter begin, Iter end) {
+        return store_multi<LCB_SET>(begin, end);
+    }
+    template <typename Range>
+    std::vector<StoreResponse> upsert_multi(const Range& kvs) {
+        return store_multi<LCB_SET>(kvs.begin(), kvs.end());
+    }
+
     inline TouchResponse touch(const TouchCommand&);
 
     inline RemoveResponse remove(const RemoveCommand&);
@@ -709,6 +1502,13 @@ public:
     }
 
     inline CounterResponse counter(const CounterCommand&);
+
+    //! @brief Read parts of a document
+    //! @see LookupInCommand
+    inline LookupInResponse lookup_in(const LookupInCommand&);
+    //! @brief Modify parts of a document
+    //! @see MutateInCommand
+    inline MutateInResponse mutate_in(const MutateInCommand&);
     inline StatsResponse stats(const std::string& key);
     inline UnlockResponse unlock(const UnlockCommand& cmd);
 
@@ -723,6 +1523,34 @@ public:
     template <typename T, typename R>
     inline Status run(const Command<T>&, Response<R>&);
 
+#ifdef LCB_CXX_HAVE_COROUTINES
+    //! @brief Schedule a command and return an object which may be
+    //! `co_await`ed for its response.
+    //! @details
+    //! The command is scheduled when the awaitable is `co_await`ed, and the
+    //! coroutine is resumed from within #wait() once the response arrives.
+    //! The coroutine may schedule further operations when resumed; these are
+    //! performed by the same (or a later) call to #wait().
+    //!
+    //! @code{c++}
+    //! Task fetch(Client& client) {
+    //!     GetResponse resp = co_await client.get_async(GetCommand("foo"));
+    //!     ...
+    //! }
+    //! @endcode
+    //! @note Only available when compiling with C++20 coroutine support
+    template <typename R, typename T>
+    inline Awaitable<T, R> run_async(const Command<T>& cmd);
+    inline Awaitable<OpInfo::Get, GetResponse> get_async(const GetCommand&);
+    template <lcb_storage_t T>
+    inline Awaitable<OpInfo::Store, StoreResponse> store_async(const StoreCommand<T>&);
+    inline Awaitable<OpInfo::Store, TouchResponse> touch_async(const TouchCommand&);
+    inline Awaitable<OpInfo::Remove, RemoveResponse> remove_async(const RemoveCommand&);
+    inline Awaitable<OpInfo::Counter, CounterResponse> counter_async(const CounterCommand&);
+    inline Awaitable<OpInfo::Unlock, UnlockResponse> unlock_async(const UnlockCommand&);
+    inline Awaitable<OpInfo::Stats, StatsResponse> stats_async(const StatsCommand&);
+#endif
+
     //! @brief Wait until client is connected
     //! @details
     //! This function will attempt to bootstrap the client. It will return a
@@ -735,6 +1563,117 @@ public:
     //! sends  requests to the server and receives their responses
     inline void wait();
 
+    //! @brief Set the memory resource used for response buffers
+    //! @details
+    //! Memory for detached query and view rows, values which must be copied
+    //! out of the network buffer and @ref BatchCommand response lists is
+    //! obtained from this resource. Objects already allocated keep a
+    //! reference to the resource they were allocated from, which must
+    //! therefore outlive them.
+    //! @param resource the resource to use, or `NULL` for the default
+    //!        (global `new`/`delete`)
+    void memory_resource(MemoryResource *resource) {
+        m_resource = resource ? resource : default_resource();
+    }
+    MemoryResource *memory_resource() const { return m_resource; }
+
+    //! @brief Set where values are compressed
+    //! @details
+    //! This must be called before #connect(), so that compression is
+    //! negotiated with the server.
+    //! @param mode where values are compressed. Use Compression::OUT together
+    //!        with #decompressor() to compress stored values and decompress
+    //!        received ones only when they are accessed
+    //! @param min_size values smaller than this are not compressed, where
+    //!        the library supports setting it. 0 for the library's default
+    inline Status compression(Compression mode, uint32_t min_size = 0);
+
+    //! @brief Decompress received values lazily
+    //! @details
+    //! Values which arrive compressed are kept compressed in their
+    //! @ref GetResponse, and are decompressed the first time they are
+    //! accessed. Values which arrive compressed are only passed through by
+    //! the library if compression is not Compression::IN or
+    //! Compression::INOUT (which decompress every value on receipt).
+    //! @param d the decompressor, or `NULL` to return compressed values as
+    //!        they are. It is not owned by the client and must outlive any
+    //!        response it is used for
+    void decompressor(const Decompressor *d) { m_decomp = d; }
+    const Decompressor *decompressor() const { return m_decomp; }
+
+    //! @brief Set the policy for retrying temporary failures
+    //! @details
+    //! The policy applies to get, store, touch, remove, counter and unlock
+    //! operations scheduled after this call, whether through this client's
+    //! own methods or through a @ref Context. Retries happen within
+    //! #wait(), and only the final outcome is delivered to the operation's
+    //! handler.
+    //! @param policy the policy. Pass a default-constructed policy to
+    //!        disable retries
+    void retry_policy(const RetryPolicy& policy) { m_retry = policy; }
+    const RetryPolicy& retry_policy() const { return m_retry; }
+
+    //! Get counters for retried operations
+    const RetryStats& retry_stats() const { return m_retrystats; }
+
+    //! @brief Enable or disable recording of operation latencies
+    //! @details
+    //! When enabled, each operation is timestamped when scheduled and its
+    //! latency recorded into a per-type histogram (see #latency()) when its
+    //! final response arrives. This costs two clock reads and an atomic
+    //! increment per operation. Queries are timed from when they are issued
+    //! until their last row has been received.
+    inline void latency_metrics(bool enabled);
+    bool latency_metrics() const { return m_timing; }
+
+    //! @brief Get the latencies recorded for a type of operation
+    //! @details
+    //! The histogram may be read (but not reset) from other threads while
+    //! operations are being recorded.
+    //! @code{c++}
+    //! const LatencyHistogram& h = client.latency(OpType::GET);
+    //! std::cout << "p99: " << h.p99() << "ns" << std::endl;
+    //! @endcode
+    inline const LatencyHistogram& latency(OpType type) const;
+
+    //! @brief Install a read cache in front of #get() and #get_multi()
+    //! @param cache the cache, or `NULL` to stop caching. The cache is not
+    //!        owned by the client and must outlive it (or be removed first)
+    void read_cache(ReadCache *cache) { m_cache = cache; }
+    ReadCache *read_cache() const { return m_cache; }
+
+    //! @brief Coalesce concurrent gets of the same key
+    //! @details
+    //! When enabled, a get scheduled (through any API) for a key which
+    //! already has a get in flight is not sent to the server. Instead it is
+    //! attached to the existing request, and every attached handler receives
+    //! the one response, sharing its value buffer. A store, remove, touch or
+    //! counter operation on the key ends the coalescing window, so later gets
+    //! are not answered with a value read before the mutation.
+    //!
+    //! Get-and-lock and get-and-touch requests are never coalesced.
+    void coalesce_gets(bool enabled) { m_coalesce = enabled; }
+    bool coalesce_gets() const { return m_coalesce; }
+    //! Number of gets which were answered by another request already in flight
+    size_t coalesced_gets() const { return m_ncoalesced; }
+
+    //! @brief Set how long durability checks are held back for grouping
+    //! @details
+    //! The durability checks of DurableResponse operations whose mutations
+    //! complete within this window are submitted as a single multi-key
+    //! check, sharing its polling rounds. With the default of 0, checks are
+    //! grouped with those whose mutations complete in the same pass of the
+    //! event loop.
+    //! @param usecs the window, in microseconds
+    void durability_window(uint32_t usecs) { m_durwindow = usecs; }
+    uint32_t durability_window() const { return m_durwindow; }
+
+    //! @private
+    Internal::Metrics *_metrics() const { return m_timing ? m_metrics.get() : NULL; }
+
+    //! @private
+    inline Internal::DurGroup& _durgroup();
+
     //! Retrieve the inner `lcb_t` for use with the C API.
     //! @return the C library handle
     inline lcb_t handle() const { return m_instance; }
@@ -750,26 +1689,87 @@ public:
     //! @private
     inline void _dispatch(int, const lcb_RESPBASE*);
 
+    //! @private
+    //! Call `fn(arg)` once the outermost response dispatch has returned,
+    //! rather than from within it
+    inline void _defer(void (*fn)(void*), void *arg);
+
     inline Status mctx_endure(const DurabilityOptions&, Handler*, Internal::MultiDurContext&);
     inline Status mctx_observe(Handler*, Internal::MultiObsContext&);
 
-    void enter() { lcb_sched_enter(m_instance); }
-    void leave() { lcb_sched_leave(m_instance); }
-    void fail() { lcb_sched_fail(m_instance); }
+    //! @private
+    //! Begin a scheduling scope. Operations scheduled until #leave() or
+    //! #fail() are only sent (or dropped) as a whole
+    void enter() {
+        lcb_sched_enter(m_instance);
+        m_entered = true;
+    }
+    //! @private
+    void leave() {
+        lcb_sched_leave(m_instance);
+        m_entered = false;
+        m_unsched.clear();
+    }
+    //! @private
+    void fail() {
+        lcb_sched_fail(m_instance);
+        m_entered = false;
+        unschedule();
+    }
 
 private:
     friend class Context;
     friend class EndureContext;
+    template <typename T> friend class Internal::RetryOp;
+    friend class Internal::GetFlight;
+    friend class Internal::DurGroup;
+    friend class Internal::HedgedGet;
+    friend class GetResponse;
     lcb_t m_instance;
     size_t remaining;
     DurabilityOptions m_duropts;
+    MemoryResource *m_resource = default_resource();
+    RetryPolicy m_retry;
+    RetryStats m_retrystats;
+    std::minstd_rand m_rng;
+    std::unique_ptr<Internal::Metrics> m_metrics;
+    bool m_timing = false;
+    ReadCache *m_cache = NULL;
+    bool m_coalesce = false;
+    size_t m_ncoalesced = 0;
+    std::unordered_map<std::string, Internal::GetFlight*> m_flights;
+    // Hedged gets with a request still out
+    std::unordered_set<Internal::HedgedGet*> m_hedges;
+    // Shared by the responses of a coalesced get while they are dispatched
+    std::shared_ptr<Internal::Inflation> m_inflating;
+    std::unique_ptr<Internal::DurGroup> m_durgroup;
+    uint32_t m_durwindow = 0;
+    const Decompressor *m_decomp = NULL;
+    struct Deferred {
+        void (*fn)(void*);
+        void *arg;
+    };
+    std::vector<Deferred> m_deferred;
+    unsigned m_dispatching = 0;
+    inline void run_deferred();
+    // Undo records for the current scheduling scope
+    std::vector<Internal::Unschedule> m_unsched;
+    bool m_entered = false;
+    inline void unscheduled(Internal::Unschedule::Kind, Handler*, Internal::GetFlight*);
+    inline void unschedule();
     Client(Client&) = delete;
 };
 } // namespace Couchbase
 
+#include <libcouchbase/couchbase++/metrics.inl.h>
 #include <libcouchbase/couchbase++/mctx.inl.h>
 #include <libcouchbase/couchbase++/endure.h>
+#include <libcouchbase/couchbase++/cache.h>
 #include <libcouchbase/couchbase++/client.inl.h>
+#include <libcouchbase/couchbase++/retry.inl.h>
 #include <libcouchbase/couchbase++/batch.inl.h>
+#ifdef LCB_CXX_HAVE_COROUTINES
+#include <libcouchbase/couchbase++/awaitable.h>
+#endif
 
 #endif
@@ -0,0 +1,170 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_ASYNC_H
+#define LCB_PLUSPLUS_ASYNC_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+
+namespace Couchbase {
+
+class AsyncClient;
+
+namespace Internal {
+extern "C" { static void asyncpoll(lcb_timer_t, lcb_t, const void*); }
+
+//! @private
+//! Base class for requests submitted to an AsyncClient. Each request is its
+//! own handler (and thus its own cookie) once scheduled.
+class AsyncRequest : public Handler {
+public:
+    virtual ~AsyncRequest() {}
+    //! Schedule the request on the I/O thread
+    virtual Status schedule(Context& ctx) = 0;
+    //! Complete the request with an error without scheduling it
+    virtual void fail(const Status&) = 0;
+    bool done() const override { return true; }
+
+    AsyncRequest *next = NULL;
+    std::vector<AsyncRequest*> *reaper = NULL;
+};
+
+//! @private
+//! Multi-producer, single-consumer intrusive queue. Producers push with a
+//! single compare-and-swap; the consumer takes the entire queue at once.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : m_head(NULL) {}
+    inline void push(T *item);
+    inline T* pop_all();
+    bool empty() const { return m_head.load() == NULL; }
+private:
+    std::atomic<T*> m_head;
+};
+
+template <typename C, typename R>
+class AsyncOp;
+} // namespace Internal
+
+//! @brief Client running its event loop on a dedicated thread
+//! @details
+//! Operations may be submitted from any number of threads. Each operation
+//! either returns a `std::future` for its response, or accepts a callback
+//! which is invoked on the I/O thread once the response arrives. Submitting
+//! an operation never blocks on the network, so a single thread may keep
+//! many operations in flight.
+//!
+//! Keys and values are copied (or moved) into the request, so the caller's
+//! buffers need not outlive the call.
+//!
+//! @code{c++}
+//! AsyncClient client("couchbase://localhost/default");
+//! client.connect();
+//! std::future<GetResponse> f = client.get("foo");
+//! // ... do other work ...
+//! GetResponse resp = f.get();
+//! @endcode
+//!
+//! @note The `key()` of a response obtained through a future is empty; use
+//!       the callback variants if the key is needed inside the response.
+class AsyncClient {
+public:
+    typedef std::function<void(GetResponse&)> GetCallback;
+    typedef std::function<void(StoreResponse&)> StoreCallback;
+
+    //! @brief Initialize the client. See Client::Client()
+    inline AsyncClient(const std::string& connstr = "couchbase://localhost/default",
+        const std::string& passwd = "", const std::string& username = "");
+
+    //! Stops the I/O thread. See #close()
+    inline ~AsyncClient();
+
+    //! @brief Bootstrap the client and start the I/O thread
+    //! @return the bootstrap status. If this fails, no I/O thread is started
+    //!         and operations will fail once the client is destroyed.
+    inline Status connect();
+
+    //! @brief Stop the I/O thread
+    //! Operations already submitted are completed before the thread exits.
+    //! Operations submitted afterwards fail immediately with `LCB_EINVAL`.
+    inline void close();
+
+    //! @brief Set how often the I/O thread checks for new operations while
+    //! other operations are in flight.
+    //! @param usec the polling interval in microseconds
+    //! @note This must be called before #connect()
+    void poll_interval(uint32_t usec) { m_interval = usec; }
+
+    //! @brief Coalesce concurrent gets of the same key. Gets submitted
+    //! while a get of the key is in flight share its response. See
+    //! Client::coalesce_gets()
+    //! @note This must be called before #connect()
+    void coalesce_gets(bool enabled) { m_coalesce = enabled; }
+
+    //! Retrieve an item
+    //! @param key the key to retrieve
+    //! @return a future for the response
+    inline std::future<GetResponse> get(std::string key);
+    //! Retrieve an item, invoking a callback (on the I/O thread) with the
+    //! response
+    inline void get(std::string key, GetCallback callback);
+
+    //! Store an item
+    //! @param mode the mutation type
+    //! @param key the key to store
+    //! @param value the value to store
+    //! @return a future for the response
+    inline std::future<StoreResponse> store(StoreMode mode, std::string key, std::string value);
+    //! Store an item, invoking a callback (on the I/O thread) with the response
+    inline void store(StoreMode mode, std::string key, std::string value,
+        StoreCallback callback);
+
+    std::future<StoreResponse> upsert(std::string key, std::string value) {
+        return store(LCB_SET, std::move(key), std::move(value));
+    }
+    std::future<StoreResponse> insert(std::string key, std::string value) {
+        return store(LCB_ADD, std::move(key), std::move(value));
+    }
+    std::future<StoreResponse> replace(std::string key, std::string value) {
+        return store(LCB_REPLACE, std::move(key), std::move(value));
+    }
+
+    //! @private
+    inline void _poll();
+
+private:
+    inline void submit(Internal::AsyncRequest *);
+    inline void fail_pending();
+    inline void run();
+
+    Client m_client;
+    Internal::MpscQueue<Internal::AsyncRequest> m_queue;
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::atomic<bool> m_idle;
+    std::atomic<bool> m_stopping;
+    // Whether the I/O thread will still drain the queue. Guarded by m_lock
+    bool m_running = false;
+    uint32_t m_interval = 1000;
+    bool m_coalesce = false;
+
+    // Only accessed by the I/O thread
+    size_t m_inflight = 0;
+    std::vector<Internal::AsyncRequest*> m_reap;
+
+    AsyncClient(AsyncClient&) = delete;
+    AsyncClient& operator=(AsyncClient&) = delete;
+};
+
+} // namespace Couchbase
+
+#include <libcouchbase/couchbase++/async.inl.h>
+
+#endif
@@ -0,0 +1,276 @@
+namespace Couchbase {
+namespace Internal {
+
+template <typename T> void
+MpscQueue<T>::push(T *item) {
+    T *head = m_head.load();
+    do {
+        item->next = head;
+    } while (!m_head.compare_exchange_weak(head, item));
+}
+
+template <typename T> T*
+MpscQueue<T>::pop_all() {
+    T *head = m_head.exchange(NULL);
+    // Items were pushed LIFO; reverse them so they are scheduled in
+    // submission order
+    T *prev = NULL;
+    while (head != NULL) {
+        T *next = head->next;
+        head->next = prev;
+        prev = head;
+        head = next;
+    }
+    return prev;
+}
+
+// Responses handed to another thread must not reference library buffers
+inline void async_detatch(GetResponse& resp) { resp.detatch(); }
+template <typename R> inline void async_detatch(R&) {}
+
+template <typename C, typename R>
+class AsyncOp : public AsyncRequest {
+public:
+    typedef std::function<void(R&)> Callback;
+
+    AsyncOp(std::string&& key, std::string&& value, Callback&& callback)
+    : m_key(std::move(key)), m_value(std::move(value)),
+      m_callback(std::move(callback)) {
+        m_cmd.key(m_key);
+    }
+
+    C& command() { return m_cmd; }
+    const std::string& value() const { return m_value; }
+    std::future<R> get_future() { return m_promise.get_future(); }
+
+    Status schedule(Context& ctx) override {
+        return ctx.add(m_cmd, this);
+    }
+
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        R resp;
+        resp.handle_response(client, cbtype, rb);
+        complete(resp);
+        reaper->push_back(this);
+    }
+
+    void fail(const Status& st) override {
+        R resp;
+        complete(R::setcode(resp, st));
+    }
+
+private:
+    void complete(R& resp) {
+        lcb_RESPBASE kb;
+        memset(&kb, 0, sizeof kb);
+        if (m_callback) {
+            kb.key = m_key.c_str();
+            kb.nkey = m_key.size();
+            resp.set_key(&kb);
+            m_callback(resp);
+        } else {
+            kb.key = "";
+            resp.set_key(&kb);
+            async_detatch(resp);
+            m_promise.set_value(std::move(resp));
+        }
+    }
+
+    std::string m_key;
+    std::string m_value;
+    C m_cmd;
+    Callback m_callback;
+    std::promise<R> m_promise;
+};
+
+extern "C" {
+static void asyncpoll(lcb_timer_t, lcb_t, const void *cookie) {
+    const_cast<AsyncClient*>(reinterpret_cast<const AsyncClient*>(cookie))->_poll();
+}
+}
+} // namespace Internal
+
+AsyncClient::AsyncClient(const std::string& connstr,
+    const std::string& passwd, const std::string& username)
+: m_client(connstr, passwd, username), m_idle(false), m_stopping(false)
+{
+}
+
+AsyncClient::~AsyncClient()
+{
+    close();
+}
+
+Status
+AsyncClient::connect()
+{
+    Status rv = m_client.connect();
+    if (rv) {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_running = true;
+        m_thread = std::thread(&AsyncClient::run, this);
+    }
+    return rv;
+}
+
+void
+AsyncClient::close()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+        m_cond.notify_one();
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    fail_pending();
+}
+
+void
+AsyncClient::fail_pending()
+{
+    Internal::AsyncRequest *req = m_queue.pop_all();
+    while (req != NULL) {
+        Internal::AsyncRequest *next = req->next;
+        req->fail(Status(LCB_EINVAL));
+        delete req;
+        req = next;
+    }
+}
+
+void
+AsyncClient::submit(Internal::AsyncRequest *req)
+{
+    if (m_stopping) {
+        req->fail(Status(LCB_EINVAL));
+        delete req;
+        return;
+    }
+    m_queue.push(req);
+    if (m_stopping) {
+        // close() may have drained the queue between the check above and
+        // the push. If the I/O thread has also exited, nothing else will
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (!m_running) {
+            fail_pending();
+        }
+        return;
+    }
+    if (m_idle) {
+        // Notify under the lock so the wakeup cannot be lost between the I/O
+        // thread's emptiness check and its wait
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_cond.notify_one();
+    }
+}
+
+void
+AsyncClient::_poll()
+{
+    if (!m_queue.empty()) {
+        m_client.breakout(true);
+    }
+}
+
+void
+AsyncClient::run()
+{
+    // The client is only touched by this thread once it has started
+    m_client.coalesce_gets(m_coalesce);
+
+    // While operations are in flight the thread is inside Client::wait(). The
+    // timer periodically breaks out of the event loop if new operations have
+    // been submitted in the meantime, so they need not wait for all in-flight
+    // operations to complete.
+    lcb_error_t err = LCB_SUCCESS;
+    lcb_timer_t timer = lcb_timer_create(m_client.handle(), this,
+        m_interval, 1, Internal::asyncpoll, &err);
+
+    for (;;) {
+        Internal::AsyncRequest *req = m_queue.pop_all();
+        if (req != NULL) {
+            Context ctx(m_client);
+            while (req != NULL) {
+                Internal::AsyncRequest *next = req->next;
+                req->reaper = &m_reap;
+                Status st = req->schedule(ctx);
+                if (st) {
+                    m_inflight++;
+                } else {
+                    req->fail(st);
+                    delete req;
+                }
+                req = next;
+            }
+            ctx.submit();
+        }
+
+        if (m_inflight) {
+            m_client.wait();
+            for (auto ii : m_reap) {
+                delete ii;
+            }
+            m_inflight -= m_reap.size();
+            m_reap.clear();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_idle = true;
+        while (m_queue.empty() && !m_stopping) {
+            m_cond.wait(guard);
+        }
+        m_idle = false;
+        if (m_queue.empty() && m_stopping) {
+            m_running = false;
+            break;
+        }
+    }
+
+    if (timer != NULL) {
+        lcb_timer_destroy(m_client.handle(), timer);
+    }
+}
+
+std::future<GetResponse>
+AsyncClient::get(std::string key)
+{
+    typedef Internal::AsyncOp<GetCommand, GetResponse> Op;
+    Op *op = new Op(std::move(key), std::string(), Op::Callback());
+    std::future<GetResponse> ret = op->get_future();
+    submit(op);
+    return ret;
+}
+
+void
+AsyncClient::get(std::string key, GetCallback callback)
+{
+    typedef Internal::AsyncOp<GetCommand, GetResponse> Op;
+    submit(new Op(std::move(key), std::string(), std::move(callback)));
+}
+
+std::future<StoreResponse>
+AsyncClient::store(StoreMode mode, std::string key, std::string value)
+{
+    typedef Internal::AsyncOp<UpsertCommand, StoreResponse> Op;
+    Op *op = new Op(std::move(key), std::move(value), Op::Callback());
+    op->command().mode(mode);
+    op->command().value(op->value());
+    std::future<StoreResponse> ret = op->get_future();
+    submit(op);
+    return ret;
+}
+
+void
+AsyncClient::store(StoreMode mode, std::string key, std::string value,
+    StoreCallback callback)
+{
+    typedef Internal::AsyncOp<UpsertCommand, StoreResponse> Op;
+    Op *op = new Op(std::move(key), std::move(value), std::move(callback));
+    op->command().mode(mode);
+    op->command().value(op->value());
+    submit(op);
+}
+
+} // namespace Couchbase
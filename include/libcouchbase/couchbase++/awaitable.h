@@ -0,0 +1,120 @@
+#ifndef LCB_PLUSPLUS_H
+#error "include <libcouchbase/couchbase++.h> first"
+#endif
+
+#ifndef LCB_PLUSPLUS_AWAITABLE_H
+#define LCB_PLUSPLUS_AWAITABLE_H
+
+#include <coroutine>
+
+namespace Couchbase {
+
+//! @brief Awaitable wrapping a single command.
+//! @details
+//! Returned by Client::run_async() and friends. The awaitable is itself the
+//! handler for the command, so no callback or response object is allocated:
+//! the response is built in place inside the coroutine frame.
+//!
+//! The coroutine is resumed from within Client::wait(), once the client has
+//! finished dispatching the response (and any others delivered along with
+//! it, such as those of coalesced gets). It may therefore schedule further
+//! operations or destroy other handlers, but must not call Client::wait()
+//! itself.
+template <typename T, typename R>
+class Awaitable : public Handler {
+public:
+    Awaitable(Client& client, const Command<T>& cmd)
+    : m_client(client), m_cmd(cmd) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        m_handle = h;
+        Context ctx(m_client);
+        Status st = ctx.add(m_cmd, this);
+        if (!st) {
+            ctx.bail();
+            R::setcode(m_resp, st);
+            return false;
+        }
+        ctx.submit();
+        return true;
+    }
+
+    R await_resume() {
+        lcb_RESPBASE kb;
+        memset(&kb, 0, sizeof kb);
+        kb.key = m_cmd.keybuf();
+        kb.nkey = m_cmd.keylen();
+        m_resp.set_key(&kb);
+        return std::move(m_resp);
+    }
+
+    //! @private
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        m_resp.handle_response(client, cbtype, rb);
+    }
+
+    //! @private
+    bool done() const override { return m_resp.done(); }
+
+    //! @private
+    void finish() override { m_client._defer(&Awaitable::resume, m_handle.address()); }
+
+private:
+    static void resume(void *handle) {
+        std::coroutine_handle<>::from_address(handle).resume();
+    }
+
+    Awaitable(const Awaitable&) = delete;
+    Awaitable& operator=(const Awaitable&) = delete;
+
+    Client& m_client;
+    Command<T> m_cmd;
+    R m_resp;
+    std::coroutine_handle<> m_handle;
+};
+
+template <typename R, typename T> Awaitable<T, R>
+Client::run_async(const Command<T>& cmd) {
+    return Awaitable<T, R>(*this, cmd);
+}
+
+Awaitable<OpInfo::Get, GetResponse>
+Client::get_async(const GetCommand& cmd) {
+    return run_async<GetResponse>(cmd);
+}
+
+template <lcb_storage_t T> Awaitable<OpInfo::Store, StoreResponse>
+Client::store_async(const StoreCommand<T>& cmd) {
+    return run_async<StoreResponse>(cmd);
+}
+
+Awaitable<OpInfo::Store, TouchResponse>
+Client::touch_async(const TouchCommand& cmd) {
+    return run_async<TouchResponse>(cmd);
+}
+
+Awaitable<OpInfo::Remove, RemoveResponse>
+Client::remove_async(const RemoveCommand& cmd) {
+    return run_async<RemoveResponse>(cmd);
+}
+
+Awaitable<OpInfo::Counter, CounterResponse>
+Client::counter_async(const CounterCommand& cmd) {
+    return run_async<CounterResponse>(cmd);
+}
+
+Awaitable<OpInfo::Unlock, UnlockResponse>
+Client::unlock_async(const UnlockCommand& cmd) {
+    return run_async<UnlockResponse>(cmd);
+}
+
+Awaitable<OpInfo::Stats, StatsResponse>
+Client::stats_async(const StatsCommand& cmd) {
+    return run_async<StatsResponse>(cmd);
+}
+
+} // namespace Couchbase
+
+#endif
@@ -33,7 +33,7 @@ Context::operator =(Context&& other) {
 
 template <typename T> Status
 Context::add(const Command<T>& cmd, Handler *handler) {
-    Status st = cmd.scheduler()(parent.handle(), handler->as_cookie(), &cmd);
+    Status st = parent.schedule(cmd, handler->as_cookie());
     if (st) {
         m_remaining++;
     }
@@ -62,7 +62,8 @@ Context::reset() {
 
 // Batched commands
 template <typename C, typename R>
-BatchCommand<C,R>::BatchCommand(Client &c) : m_ctx(c) {
+BatchCommand<C,R>::BatchCommand(Client &c)
+: m_ctx(c), m_resplist(Internal::ResourceAllocator<R>(c.memory_resource())) {
 }
 
 template <typename C, typename R> Status
@@ -71,6 +72,56 @@ BatchCommand<C,R>::add(const C& cmd) {
     return m_ctx.add(cmd, &m_resplist.back());
 }
 
+namespace Internal {
+template <typename R>
+ResponseArena<R>::ResponseArena(size_t chunksize)
+: m_chunksize(chunksize ? chunksize : 1) {
+}
+
+template <typename R> R&
+ResponseArena<R>::alloc() {
+    if (m_used == m_chunks.size() * m_chunksize) {
+        m_chunks.emplace_back(new R[m_chunksize]);
+    }
+    size_t ix = m_used++;
+    return m_chunks[ix / m_chunksize][ix % m_chunksize];
+}
+
+template <typename R> void
+ResponseArena<R>::reserve(size_t n) {
+    while (m_chunks.size() * m_chunksize < n) {
+        m_chunks.emplace_back(new R[m_chunksize]);
+    }
+}
+
+template <typename R> void
+ResponseArena<R>::reset() {
+    // Release whatever the previous responses hold (e.g. value buffers),
+    // but keep the chunks themselves
+    for (size_t ii = 0; ii < m_used; ii++) {
+        m_chunks[ii / m_chunksize][ii % m_chunksize] = R();
+    }
+    m_used = 0;
+}
+} // namespace Internal
+
+template <typename C, typename R>
+ArenaBatchCommand<C,R>::ArenaBatchCommand(Client& c, size_t reserve, size_t chunksize)
+: m_ctx(c), m_arena(chunksize) {
+    m_arena.reserve(reserve);
+}
+
+template <typename C, typename R> Status
+ArenaBatchCommand<C,R>::add(const C& cmd) {
+    return m_ctx.add(cmd, &m_arena.alloc());
+}
+
+template <typename C, typename R> void
+ArenaBatchCommand<C,R>::reset() {
+    m_arena.reset();
+    m_ctx.reset();
+}
+
 // Callback stuff
 template <typename C, typename R>
 CallbackCommand<C,R>::CallbackCommand(Client& c, CallbackType& cb)
@@ -0,0 +1,104 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_BULK_H
+#define LCB_PLUSPLUS_BULK_H
+
+namespace Couchbase {
+
+//! @brief Streams a large number of mutations with a bounded window
+//! @details
+//! The writer keeps up to a fixed number of mutations in flight. As
+//! responses arrive, new mutations are scheduled from within the response
+//! callback, so the network pipeline stays full while memory use is bounded
+//! by the window size rather than by the size of the dataset.
+//!
+//! Items may be pulled from a source function:
+//!
+//! @code{c++}
+//! std::ifstream in("data.tsv");
+//! BulkWriter writer(client, 1024);
+//! writer.on_error([](const StoreResponse& resp) {
+//!     std::cerr << resp.key() << ": " << resp.status() << std::endl;
+//! });
+//! writer.load([&](std::string& key, std::string& value) {
+//!     return std::getline(in, key, '\t') && std::getline(in, value);
+//! });
+//! @endcode
+//!
+//! or pushed one at a time with #add(), which runs the event loop whenever
+//! the window is full. Call #flush() (or destroy the writer) to wait for
+//! the remaining mutations.
+//!
+//! @warning While the writer has mutations in flight, no other @ref Context
+//!          may be active on the client.
+class BulkWriter : private Handler {
+public:
+    //! Produces the next item. Return false once there are no more items
+    typedef std::function<bool(std::string& key, std::string& value)> Source;
+    //! Invoked for each mutation which failed
+    typedef std::function<void(const StoreResponse&)> ErrorCallback;
+
+    //! @param client the client to write with
+    //! @param window the maximum number of mutations in flight
+    //! @param mode the type of mutation to perform
+    inline BulkWriter(Client& client, size_t window = 512, StoreMode mode = LCB_SET);
+
+    //! Waits for all mutations in flight
+    ~BulkWriter() { flush(); }
+
+    //! Set the callback for failed mutations
+    void on_error(ErrorCallback callback) { m_errcb = std::move(callback); }
+
+    //! @brief Schedule a single mutation.
+    //! If the window is full, this runs the event loop until there is room.
+    //! The key and value are copied by the library and need not remain
+    //! valid after this returns.
+    //! @return the scheduling status. Failures to schedule are also passed
+    //!         to the error callback
+    inline Status add(const std::string& key, const std::string& value);
+
+    //! @brief Write all items produced by `source`, and wait for them to
+    //! complete
+    inline void load(Source source);
+
+    //! Wait for all mutations in flight to complete
+    inline void flush();
+
+    //! Number of mutations in flight
+    size_t inflight() const { return m_inflight; }
+    //! Number of mutations which have completed successfully
+    size_t succeeded() const { return m_succeeded; }
+    //! Number of mutations which have failed (including scheduling failures)
+    size_t failed() const { return m_failed; }
+
+private:
+    BulkWriter(const BulkWriter&) = delete;
+    BulkWriter& operator=(const BulkWriter&) = delete;
+
+    inline void handle_response(Client&, int, const lcb_RESPBASE *) override;
+    bool done() const override { return true; }
+    inline void finish() override;
+    inline Status schedule(Context& ctx, const std::string& key, const std::string& value);
+    inline void refill();
+
+    Client& m_client;
+    ErrorCallback m_errcb;
+    Source m_source;
+    size_t m_window;
+    size_t m_lowat;
+    StoreMode m_mode;
+    size_t m_inflight = 0;
+    size_t m_succeeded = 0;
+    size_t m_failed = 0;
+    bool m_blocked = false;
+    std::string m_key;
+    std::string m_value;
+};
+
+} // namespace Couchbase
+
+#include <libcouchbase/couchbase++/bulk.inl.h>
+
+#endif
@@ -0,0 +1,109 @@
+namespace Couchbase {
+
+BulkWriter::BulkWriter(Client& client, size_t window, StoreMode mode)
+: m_client(client), m_window(window ? window : 1), m_mode(mode)
+{
+    // Refill (or unblock #add()) once a quarter of the window is free, so
+    // that new mutations are scheduled in batches rather than one by one
+    m_lowat = m_window - (m_window + 3) / 4;
+}
+
+Status
+BulkWriter::schedule(Context& ctx, const std::string& key, const std::string& value)
+{
+    UpsertCommand cmd(key, value);
+    cmd.mode(m_mode);
+    Status st = ctx.add(cmd, this);
+    if (st) {
+        m_inflight++;
+        return st;
+    }
+
+    m_failed++;
+    if (m_errcb) {
+        StoreResponse resp;
+        lcb_RESPBASE kb;
+        memset(&kb, 0, sizeof kb);
+        kb.key = key.c_str();
+        kb.nkey = key.size();
+        resp.set_key(&kb);
+        m_errcb(StoreResponse::setcode(resp, st));
+    }
+    return st;
+}
+
+Status
+BulkWriter::add(const std::string& key, const std::string& value)
+{
+    if (m_inflight >= m_window) {
+        m_blocked = true;
+        m_client.wait();
+        m_blocked = false;
+    }
+    Context ctx(m_client);
+    Status st = schedule(ctx, key, value);
+    ctx.submit();
+    return st;
+}
+
+void
+BulkWriter::refill()
+{
+    Context ctx(m_client);
+    while (m_inflight < m_window) {
+        if (!m_source(m_key, m_value)) {
+            m_source = NULL;
+            break;
+        }
+        schedule(ctx, m_key, m_value);
+    }
+    ctx.submit();
+}
+
+void
+BulkWriter::load(Source source)
+{
+    m_source = std::move(source);
+    refill();
+    flush();
+}
+
+void
+BulkWriter::flush()
+{
+    while (m_inflight) {
+        m_client.wait();
+    }
+}
+
+void
+BulkWriter::handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb)
+{
+    m_inflight--;
+    if (rb->rc == LCB_SUCCESS) {
+        m_succeeded++;
+        return;
+    }
+    m_failed++;
+    if (m_errcb) {
+        StoreResponse resp;
+        resp.handle_response(client, cbtype, rb);
+        m_errcb(resp);
+    }
+}
+
+void
+BulkWriter::finish()
+{
+    if (m_inflight > m_lowat) {
+        return;
+    }
+    if (m_source) {
+        // Scheduled from within the callback, so the event loop keeps running
+        refill();
+    } else if (m_blocked) {
+        m_client.breakout(true);
+    }
+}
+
+} // namespace Couchbase
@@ -0,0 +1,231 @@
+#ifndef LCB_PLUSPLUS_H
+#error "include <libcouchbase/couchbase++.h> first"
+#endif
+
+#ifndef LCB_PLUSPLUS_CACHE_H
+#define LCB_PLUSPLUS_CACHE_H
+
+#include <unordered_map>
+
+namespace Couchbase {
+
+//! @brief In-process cache of documents read through a @ref Client
+//! @details
+//! Once installed with Client::read_cache(), successful Client::get() and
+//! Client::get_multi() results are cached by key, and later reads of the
+//! same key are answered from memory until the entry's TTL expires. Any
+//! store, remove, touch or counter operation scheduled through the same
+//! client invalidates the key.
+//!
+//! The value is copied out of the network buffer once, when it is cached.
+//! Responses returned from the cache share that copy rather than copying
+//! it again. Values which arrived compressed are cached compressed, and are
+//! only decompressed by the responses whose value is accessed (see
+//! Client::decompressor()).
+//!
+//! Entries are evicted with the CLOCK algorithm (an approximation of LRU
+//! which does not reorder anything on a hit) once the memory cap is reached.
+//!
+//! @code{c++}
+//! ReadCache cache(64 * 1024 * 1024, 500);
+//! client.read_cache(&cache);
+//! GetResponse resp = client.get("config::flags"); // miss; fetched
+//! resp = client.get("config::flags"); // hit
+//! std::cout << cache.stats().hits << std::endl;
+//! @endcode
+//!
+//! @note Mutations made by other clients are not seen until the entry
+//!       expires; pick a TTL accordingly. The cache is not thread safe and
+//!       should be used by a single client.
+class ReadCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        //! Entries removed to stay under the memory cap
+        size_t evictions = 0;
+        //! Entries removed because of a local mutation
+        size_t invalidations = 0;
+    };
+
+    //! @param max_bytes the approximate maximum memory used by cached keys
+    //!        and values
+    //! @param ttl how long entries remain valid for, in milliseconds
+    ReadCache(size_t max_bytes = 16 * 1024 * 1024, uint32_t ttl = 1000)
+    : m_maxbytes(max_bytes), m_ttl(ttl) {}
+
+    //! @brief Look up a key
+    //! @return the cached response, or NULL if the key is not cached or
+    //!         its entry has expired
+    inline const GetResponse *find(const char *key, size_t nkey);
+
+    //! @brief Cache a response, replacing any existing entry for its key
+    //! @param key the document ID
+    //! @param resp a successful response. If it refers to a library buffer,
+    //!        it is detached (copied) first, so the copy is shared with the
+    //!        cache rather than made again
+    //! @param ttl the TTL for this entry, in milliseconds. 0 to use the
+    //!        cache's default
+    inline void insert(const char *key, size_t nkey, GetResponse& resp, uint32_t ttl = 0);
+
+    //! Remove a key from the cache
+    inline void invalidate(const char *key, size_t nkey);
+
+    //! Remove all entries
+    inline void clear();
+
+    const Stats& stats() const { return m_stats; }
+    //! Number of cached entries
+    size_t size() const { return m_index.size(); }
+    //! Approximate memory used by cached entries
+    size_t bytes() const { return m_bytes; }
+
+private:
+    ReadCache(const ReadCache&) = delete;
+    ReadCache& operator=(const ReadCache&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+    // Rough per-entry overhead of the slot and index
+    static const size_t OVERHEAD = 96;
+
+    struct Entry {
+        std::string key;
+        GetResponse resp;
+        Clock::time_point expiry;
+        // Charged against the cap when the entry was inserted
+        size_t cost = 0;
+        bool used = false;
+        bool referenced = false;
+    };
+
+    inline void remove(size_t slot);
+    inline size_t alloc_slot();
+    inline void evict(size_t needed);
+
+    std::vector<Entry> m_slots;
+    std::vector<size_t> m_free;
+    std::unordered_map<std::string, size_t> m_index;
+    std::string m_lookup;
+    size_t m_hand = 0;
+    size_t m_bytes = 0;
+    size_t m_maxbytes;
+    uint32_t m_ttl;
+    Stats m_stats;
+};
+
+const GetResponse *
+ReadCache::find(const char *key, size_t nkey)
+{
+    m_lookup.assign(key, nkey);
+    auto ii = m_index.find(m_lookup);
+    if (ii == m_index.end()) {
+        m_stats.misses++;
+        return NULL;
+    }
+    Entry& ent = m_slots[ii->second];
+    if (ent.expiry <= Clock::now()) {
+        remove(ii->second);
+        m_stats.misses++;
+        return NULL;
+    }
+    ent.referenced = true;
+    m_stats.hits++;
+    return &ent.resp;
+}
+
+void
+ReadCache::insert(const char *key, size_t nkey, GetResponse& resp, uint32_t ttl)
+{
+    invalidate(key, nkey);
+    // Sized without decompressing the value, which would defeat lazy
+    // decompression for every cached get
+    size_t cost = nkey + resp.footprint() + OVERHEAD;
+    if (cost > m_maxbytes) {
+        return;
+    }
+    evict(cost);
+
+    resp.detatch();
+    size_t slot = alloc_slot();
+    Entry& ent = m_slots[slot];
+    ent.key.assign(key, nkey);
+    ent.resp.assign_shared(resp);
+    ent.cost = cost;
+    ent.expiry = Clock::now() + std::chrono::milliseconds(ttl ? ttl : m_ttl);
+    ent.used = true;
+    ent.referenced = false;
+    m_index[ent.key] = slot;
+    m_bytes += cost;
+}
+
+void
+ReadCache::invalidate(const char *key, size_t nkey)
+{
+    if (m_index.empty()) {
+        return;
+    }
+    m_lookup.assign(key, nkey);
+    auto ii = m_index.find(m_lookup);
+    if (ii != m_index.end()) {
+        remove(ii->second);
+        m_stats.invalidations++;
+    }
+}
+
+void
+ReadCache::clear()
+{
+    m_slots.clear();
+    m_free.clear();
+    m_index.clear();
+    m_hand = 0;
+    m_bytes = 0;
+}
+
+void
+ReadCache::remove(size_t slot)
+{
+    Entry& ent = m_slots[slot];
+    m_bytes -= ent.cost;
+    m_index.erase(ent.key);
+    ent.resp.clear();
+    ent.used = false;
+    m_free.push_back(slot);
+}
+
+size_t
+ReadCache::alloc_slot()
+{
+    if (!m_free.empty()) {
+        size_t slot = m_free.back();
+        m_free.pop_back();
+        return slot;
+    }
+    m_slots.push_back(Entry());
+    return m_slots.size() - 1;
+}
+
+void
+ReadCache::evict(size_t needed)
+{
+    // Sweep the clock hand, giving referenced entries a second chance
+    while (m_bytes + needed > m_maxbytes && !m_index.empty()) {
+        if (m_hand >= m_slots.size()) {
+            m_hand = 0;
+        }
+        Entry& ent = m_slots[m_hand];
+        if (ent.used) {
+            if (ent.referenced) {
+                ent.referenced = false;
+            } else {
+                remove(m_hand);
+                m_stats.evictions++;
+            }
+        }
+        m_hand++;
+    }
+}
+
+} // namespace Couchbase
+
+#endif
@@ -18,11 +18,38 @@ void
 Client::_dispatch(int cbtype, const lcb_RESPBASE *r)
 {
     auto *bresp = reinterpret_cast<Handler*>(r->cookie);
+    m_dispatching++;
     bresp->handle_response(*this, cbtype, r);
     if (bresp->done()) {
         remaining--;
+        bresp->finish();
         breakout();
     }
+    if (--m_dispatching == 0 && !m_deferred.empty()) {
+        run_deferred();
+    }
+}
+
+void
+Client::_defer(void (*fn)(void*), void *arg)
+{
+    Deferred d = { fn, arg };
+    m_deferred.push_back(d);
+}
+
+void
+Client::run_deferred()
+{
+    // Deferred work may itself dispatch responses (e.g. by failing to
+    // schedule), which must not run the list again; it is counted as a
+    // dispatch. Anything deferred meanwhile is appended and run here.
+    m_dispatching++;
+    for (size_t ii = 0; ii < m_deferred.size(); ii++) {
+        Deferred d = m_deferred[ii];
+        d.fn(d.arg);
+    }
+    m_deferred.clear();
+    m_dispatching--;
 }
 
 Client::Client(const std::string& connstr, const std::string& passwd, const std::string& username)
@@ -42,11 +69,15 @@ Client::Client(const std::string& connstr, const std::string& passwd, const std:
         throw rv;
     }
     lcb_set_cookie(m_instance, this);
-}
 
-Client::~Client()
-{
-    lcb_destroy(m_instance);
+    // Each client needs its own jitter sequence, otherwise clients started
+    // together would retry in lockstep
+    std::random_device rd;
+    std::seed_seq seed = {
+        static_cast<uint32_t>(rd()),
+        static_cast<uint32_t>(Internal::now_ns()),
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this)) };
+    m_rng.seed(seed);
 }
 
 void
@@ -71,9 +102,406 @@ Client::connect()
     return ret;
 }
 
+namespace Internal {
+// Operations after which a cached copy of the document is stale
+template <typename T> struct Mutates { static const bool value = false; };
+template <> struct Mutates<OpInfo::Store> { static const bool value = true; };
+template <> struct Mutates<OpInfo::Remove> { static const bool value = true; };
+template <> struct Mutates<OpInfo::Touch> { static const bool value = true; };
+template <> struct Mutates<OpInfo::Counter> { static const bool value = true; };
+template <> struct Mutates<OpInfo::SubdocMutate> { static const bool value = true; };
+
+// Plain reads (not get-and-lock or get-and-touch) may be served from cache
+// or coalesced
+inline bool cacheable(const Command<OpInfo::Get>& cmd) {
+    return !(&cmd)->lock && !(&cmd)->exptime;
+}
+template <typename T> inline bool cacheable(const Command<T>&) { return false; }
+
+//! @private
+//! A get in flight, to which further gets of the same key are attached.
+//! The first handler receives the response directly; the others receive a
+//! copy of it (with their own cookie) through Client::_dispatch(), so each
+//! is completed with the client's usual bookkeeping.
+class GetFlight : public Handler {
+public:
+    GetFlight(Client& client, const char *key, size_t nkey, Handler *first)
+    : m_client(client), m_key(key, nkey), m_first(first) {}
+
+    void attach(Handler *handler) { m_waiters.push_back(handler); }
+
+    //! Remove a handler whose scheduling was failed
+    void detach(Handler *handler) {
+        for (size_t ii = m_waiters.size(); ii > 0; ii--) {
+            if (m_waiters[ii - 1] == handler) {
+                m_waiters.erase(m_waiters.begin() + (ii - 1));
+                return;
+            }
+        }
+    }
+
+    //! Stop accepting further handlers
+    void close() {
+        if (m_indexed) {
+            m_client.m_flights.erase(m_key);
+            m_indexed = false;
+        }
+    }
+
+    void index() {
+        m_client.m_flights[m_key] = this;
+        m_indexed = true;
+    }
+
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        close();
+        const lcb_RESPGET *get = reinterpret_cast<const lcb_RESPGET*>(rb);
+        if (rb->rc == LCB_SUCCESS && (get->datatype & LCB_VALUE_F_SNAPPYCOMP) && !m_waiters.empty()) {
+            // Every response for the value shares one decompressed copy
+            client.m_inflating = Inflation::create(client.decompressor(), get->value, get->nvalue);
+        }
+        for (auto waiter : m_waiters) {
+            lcb_RESPGET resp = *reinterpret_cast<const lcb_RESPGET*>(rb);
+            resp.cookie = waiter;
+            client._dispatch(cbtype, reinterpret_cast<const lcb_RESPBASE*>(&resp));
+        }
+        m_first->handle_response(client, cbtype, rb);
+        client.m_inflating.reset();
+    }
+
+    bool done() const override { return m_first->done(); }
+
+    void finish() override {
+        m_first->finish();
+        delete this;
+    }
+
+private:
+    Client& m_client;
+    std::string m_key;
+    Handler *m_first;
+    std::vector<Handler*> m_waiters;
+    bool m_indexed = false;
+};
+
+//! @private
+//! Collects the responses of a replica read. ReplicaMode::ALL yields one
+//! response per replica, the last of which is flagged as final.
+class ReplicaCollector : public Handler {
+public:
+    ReplicaCollector(ReplicaMode mode) : m_mode(mode) {}
+
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        responses.push_back(GetResponse());
+        responses.back().handle_response(client, cbtype, rb);
+        responses.back().set_key(rb);
+        m_final = m_mode != ReplicaMode::ALL || (rb->rflags & LCB_RESP_F_FINAL);
+    }
+
+    bool done() const override { return m_final; }
+
+    std::vector<GetResponse> responses;
+
+private:
+    ReplicaMode m_mode;
+    bool m_final = false;
+};
+
+extern "C" {
+static void hedgetimer(lcb_timer_t timer, lcb_t, const void *cookie);
+}
+
+//! @private
+//! A get which is also sent to a replica if the active node is slow. Each
+//! request has its own handler (a "leg"), so any handler the client
+//! interposes completes normally. The first usable response is delivered
+//! to the target and stops the event loop; the object is freed once both
+//! legs have completed.
+class HedgedGet {
+public:
+    HedgedGet(Client& client, const GetCommand& cmd, GetResponse& target)
+    : m_client(client), m_cmd(cmd), m_key(cmd.keybuf(), cmd.keylen()), m_target(&target) {
+        m_cmd.key(m_key);
+        m_active.parent = m_replica.parent = this;
+        m_client.m_hedges.insert(this);
+    }
+
+    Status start(uint32_t delay) {
+        Status st = send(m_cmd, m_active);
+        if (!st) {
+            return st;
+        }
+        lcb_error_t err = LCB_SUCCESS;
+        m_timer = lcb_timer_create(m_client.handle(), this, delay, 0, hedgetimer, &err);
+        if (err != LCB_SUCCESS) {
+            m_timer = NULL;
+        }
+        return st;
+    }
+
+    ~HedgedGet() {
+        cancel_timer();
+        m_client.m_hedges.erase(this);
+    }
+
+    void fire() {
+        cancel_timer();
+        if (m_target != NULL) {
+            send_replica();
+        }
+    }
+
+    void cancel_timer() {
+        if (m_timer != NULL) {
+            lcb_timer_destroy(m_client.handle(), m_timer);
+            m_timer = NULL;
+        }
+    }
+
+private:
+    struct Leg : public Handler {
+        void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+            pending = false;
+            if (abandoned) {
+                // No longer counted as remaining; offset the decrement
+                // Client::_dispatch() makes for it
+                client.remaining++;
+            }
+            parent->leg_response(*this, client, cbtype, rb);
+        }
+        bool done() const override { return true; }
+        void finish() override { parent->leg_done(); }
+        HedgedGet *parent = NULL;
+        bool pending = false;
+        bool abandoned = false;
+    };
+
+    template <typename C> Status send(const C& cmd, Leg& leg) {
+        m_client.enter();
+        Status st = m_client.schedule(cmd, &leg);
+        if (st) {
+            m_client.leave();
+            m_client.remaining++;
+            leg.pending = true;
+        } else {
+            m_client.fail();
+        }
+        return st;
+    }
+
+    Status send_replica() {
+        m_sent_replica = true;
+        GetReplicaCommand cmd(m_key);
+        cmd.mode(ReplicaMode::FIRST);
+        return send(cmd, m_replica);
+    }
+
+    //! Stop waiting for a request whose response is no longer needed, so
+    //! that it does not hold up the next wait on the client
+    void abandon(Leg& leg) {
+        if (leg.pending && !leg.abandoned) {
+            leg.abandoned = true;
+            m_client.remaining--;
+        }
+    }
+
+    void leg_response(Leg& leg, Client& client, int cbtype, const lcb_RESPBASE *rb) {
+        if (m_target == NULL) {
+            return; // Already answered
+        }
+        Status st(rb->rc);
+        if (&leg == &m_active) {
+            cancel_timer();
+            // A missing item is authoritative. Otherwise, if the active node
+            // failed, try a replica now rather than waiting for the timer
+            if (!st && st != LCB_KEY_ENOENT && !m_sent_replica) {
+                if (send_replica()) {
+                    return;
+                }
+            }
+        }
+        if (!st && st != LCB_KEY_ENOENT && (m_active.pending || m_replica.pending)) {
+            return; // Wait for the other request
+        }
+        m_target->handle_response(client, cbtype, rb);
+        m_target = NULL;
+        cancel_timer();
+        abandon(m_active);
+        abandon(m_replica);
+        client.breakout(true);
+    }
+
+    void leg_done() {
+        if (!m_active.pending && !m_replica.pending && m_timer == NULL) {
+            delete this;
+        }
+    }
+
+    Client& m_client;
+    GetCommand m_cmd;
+    std::string m_key;
+    GetResponse *m_target;
+    Leg m_active;
+    Leg m_replica;
+    lcb_timer_t m_timer = NULL;
+    bool m_sent_replica = false;
+};
+
+extern "C" {
+static void hedgetimer(lcb_timer_t, lcb_t, const void *cookie) {
+    const_cast<HedgedGet*>(reinterpret_cast<const HedgedGet*>(cookie))->fire();
+}
+}
+} // namespace Internal
+
+Client::~Client()
+{
+    // A hedged get's losing request may still be out
+    for (auto hedge : m_hedges) {
+        hedge->cancel_timer();
+    }
+    m_durgroup.reset();
+    lcb_destroy(m_instance);
+    while (!m_hedges.empty()) {
+        delete *m_hedges.begin();
+    }
+}
+
 template <typename T> Status
 Client::schedule(const Command<T>& command, Handler *handler) {
-    return command.scheduler()(handle(), handler, &command);
+    if (m_cache && Internal::Mutates<T>::value) {
+        m_cache->invalidate(command.keybuf(), command.keylen());
+    }
+    if (Internal::Mutates<T>::value && !m_flights.empty()) {
+        auto ii = m_flights.find(std::string(command.keybuf(), command.keylen()));
+        if (ii != m_flights.end()) {
+            ii->second->close();
+        }
+    }
+
+    Internal::TimedOp *timed = NULL;
+    if (m_timing) {
+        timed = m_metrics->wrap(Internal::OpTypeOf<T>::value, handler, 1);
+        handler = timed;
+    }
+
+    Internal::GetFlight *flight = NULL;
+    if (m_coalesce && Internal::cacheable(command)) {
+        auto ii = m_flights.find(std::string(command.keybuf(), command.keylen()));
+        if (ii != m_flights.end()) {
+            ii->second->attach(handler);
+            m_ncoalesced++;
+            if (timed != NULL) {
+                unscheduled(Internal::Unschedule::TIMED, timed, NULL);
+            }
+            unscheduled(Internal::Unschedule::WAITER, handler, ii->second);
+            return Status();
+        }
+        flight = new Internal::GetFlight(*this, command.keybuf(), command.keylen(), handler);
+        handler = flight;
+    }
+
+    Status st;
+    Internal::RetryOp<T> *op = NULL;
+    if (m_retry.enabled() && Internal::RetryOp<T>::applies(&command)) {
+        op = new Internal::RetryOp<T>(*this, &command, command.scheduler(), handler);
+        st = op->schedule();
+        if (!st) {
+            delete op;
+        }
+    } else {
+        st = command.scheduler()(handle(), handler, &command);
+    }
+
+    if (!st) {
+        delete flight;
+        if (timed != NULL) {
+            m_metrics->release(timed);
+        }
+        return st;
+    }
+
+    // Record everything allocated for the operation, in order, so that
+    // failing the scope can release it in reverse
+    if (timed != NULL) {
+        unscheduled(Internal::Unschedule::TIMED, timed, NULL);
+    }
+    if (flight != NULL) {
+        // Indexed straight away, so later gets in the same scope coalesce
+        flight->index();
+        unscheduled(Internal::Unschedule::FLIGHT, NULL, flight);
+    }
+    if (op != NULL) {
+        unscheduled(Internal::Unschedule::RETRY, op, NULL);
+    }
+    return st;
+}
+
+void
+Client::unscheduled(Internal::Unschedule::Kind kind, Handler *handler, Internal::GetFlight *flight)
+{
+    if (m_entered) {
+        Internal::Unschedule u = { kind, handler, flight };
+        m_unsched.push_back(u);
+    }
+}
+
+void
+Client::unschedule()
+{
+    // The library has dropped every operation scheduled in the scope, so
+    // nothing will complete the wrappers created for them
+    for (size_t ii = m_unsched.size(); ii > 0; ii--) {
+        const Internal::Unschedule& u = m_unsched[ii - 1];
+        switch (u.kind) {
+        case Internal::Unschedule::TIMED:
+            m_metrics->release(static_cast<Internal::TimedOp*>(u.handler));
+            break;
+        case Internal::Unschedule::RETRY:
+            delete u.handler;
+            break;
+        case Internal::Unschedule::FLIGHT:
+            u.flight->close();
+            delete u.flight;
+            break;
+        case Internal::Unschedule::WAITER:
+            u.flight->detach(u.handler);
+            m_ncoalesced--;
+            break;
+        }
+    }
+    m_unsched.clear();
+}
+
+Status
+Client::compression(Compression mode, uint32_t min_size) {
+    int opts = static_cast<int>(mode);
+    Status st = lcb_cntl(m_instance, LCB_CNTL_SET, LCB_CNTL_COMPRESSION_OPTS, &opts);
+#ifdef LCB_CNTL_COMPRESSION_MIN_SIZE
+    if (st && min_size) {
+        st = lcb_cntl(m_instance, LCB_CNTL_SET, LCB_CNTL_COMPRESSION_MIN_SIZE, &min_size);
+    }
+#else
+    (void)min_size;
+#endif
+    return st;
+}
+
+void
+Client::latency_metrics(bool enabled) {
+    if (enabled && !m_metrics) {
+        m_metrics.reset(new Internal::Metrics());
+    }
+    m_timing = enabled;
+}
+
+const LatencyHistogram&
+Client::latency(OpType type) const {
+    static const LatencyHistogram empty;
+    if (!m_metrics) {
+        return empty;
+    }
+    return m_metrics->histograms[static_cast<size_t>(type)];
 }
 
 template <typename T, typename R> Status
@@ -84,6 +512,9 @@ Client::run(const Command<T>& command, Response<R>& response) {
         fail();
     } else {
         leave();
+        // Counted, so that its response stops the event loop even if other
+        // requests (e.g. a hedged get's losing request) are still out
+        remaining++;
         wait();
     }
 
@@ -94,10 +525,131 @@ Client::run(const Command<T>& command, Response<R>& response) {
 GetResponse
 Client::get(const GetCommand& cmd) {
     GetResponse resp;
+    bool cacheable = m_cache && Internal::cacheable(cmd);
+    if (cacheable) {
+        const GetResponse *hit = m_cache->find(cmd.keybuf(), cmd.keylen());
+        if (hit != NULL) {
+            resp.assign_shared(*hit);
+            resp.set_key(cmd.keybuf(), cmd.keylen());
+            return resp;
+        }
+    }
+
     run(cmd, resp);
+    if (cacheable && resp.status().success()) {
+        m_cache->insert(cmd.keybuf(), cmd.keylen(), resp);
+    }
+    return resp;
+}
+
+std::vector<GetResponse>
+Client::get_multi(const std::vector<std::string>& keys) {
+    // Each response is its own handler; the vector is sized up front so
+    // the cookies remain valid until all responses have arrived
+    std::vector<GetResponse> ret(keys.size());
+    std::vector<bool> cached;
+    if (m_cache) {
+        cached.resize(keys.size());
+    }
+
+    Context ctx(*this);
+    for (size_t ii = 0; ii < keys.size(); ii++) {
+        if (m_cache) {
+            const GetResponse *hit = m_cache->find(keys[ii].c_str(), keys[ii].size());
+            if (hit != NULL) {
+                ret[ii].assign_shared(*hit);
+                cached[ii] = true;
+                continue;
+            }
+        }
+        Status st = ctx.add(GetCommand(keys[ii]), &ret[ii]);
+        if (!st) {
+            GetResponse::setcode(ret[ii], st);
+        }
+    }
+    ctx.submit();
+    wait();
+
+    for (size_t ii = 0; ii < keys.size(); ii++) {
+        ret[ii].set_key(keys[ii].c_str(), keys[ii].size());
+        if (m_cache && !cached[ii] && ret[ii].status().success()) {
+            m_cache->insert(keys[ii].c_str(), keys[ii].size(), ret[ii]);
+        }
+    }
+    return ret;
+}
+
+std::vector<GetResponse>
+Client::get_replicas(const GetReplicaCommand& cmd) {
+    Internal::ReplicaCollector collector(cmd.mode());
+    enter();
+    Status st = schedule(cmd, &collector);
+    if (!st) {
+        fail();
+    } else {
+        leave();
+        wait();
+    }
+    if (!st) {
+        collector.responses.push_back(GetResponse());
+        GetResponse::setcode(collector.responses.back(), st);
+        collector.responses.back().set_key(cmd.keybuf(), cmd.keylen());
+    }
+    return std::move(collector.responses);
+}
+
+GetResponse
+Client::get_replica(const GetReplicaCommand& cmd) {
+    std::vector<GetResponse> resps = get_replicas(cmd);
+    GetResponse ret;
+    for (auto& resp : resps) {
+        if (resp.status().success()) {
+            return std::move(resp);
+        }
+    }
+    if (!resps.empty()) {
+        ret = std::move(resps.back());
+    }
+    ret.set_key(cmd.keybuf(), cmd.keylen());
+    return ret;
+}
+
+GetResponse
+Client::get_hedged(const GetCommand& cmd, uint32_t delay) {
+    GetResponse resp;
+    Internal::HedgedGet *op = new Internal::HedgedGet(*this, cmd, resp);
+    Status st = op->start(delay);
+    if (!st) {
+        delete op;
+        GetResponse::setcode(resp, st);
+        return resp;
+    }
+    wait();
+    resp.set_key(cmd.keybuf(), cmd.keylen());
     return resp;
 }
 
+template <StoreMode M, typename Iter> std::vector<StoreResponse>
+Client::store_multi(Iter begin, Iter end) {
+    std::vector<StoreResponse> ret(std::distance(begin, end));
+    Context ctx(*this);
+    size_t ix = 0;
+    for (Iter ii = begin; ii != end; ++ii, ++ix) {
+        Status st = ctx.add(StoreCommand<M>(ii->first, ii->second), &ret[ix]);
+        if (!st) {
+            StoreResponse::setcode(ret[ix], st);
+        }
+    }
+    ctx.submit();
+    wait();
+
+    ix = 0;
+    for (Iter ii = begin; ii != end; ++ii, ++ix) {
+        ret[ix].set_key(ii->first.c_str(), ii->first.size());
+    }
+    return ret;
+}
+
 TouchResponse
 Client::touch(const TouchCommand& cmd) {
     TouchResponse resp;
@@ -119,6 +671,22 @@ Client::remove(const RemoveCommand& cmd) {
     return resp;
 }
 
+LookupInResponse
+Client::lookup_in(const LookupInCommand& cmd) {
+    LookupInResponse resp;
+    resp.m_results.expect(cmd.size());
+    run(cmd, resp);
+    return resp;
+}
+
+MutateInResponse
+Client::mutate_in(const MutateInCommand& cmd) {
+    MutateInResponse resp;
+    resp.m_results.expect(cmd.size());
+    run(cmd, resp);
+    return resp;
+}
+
 CounterResponse
 Client::counter(const CounterCommand& cmd) {
     CounterResponse resp;
@@ -176,34 +744,55 @@ Client::mctx_endure(const DurabilityOptions& opts,
     lcb_MULTICMD_CTX *mctx = lcb_endure3_ctxnew(m_instance, &opts, &rv);
     if (mctx == NULL) {
     } else {
-        out = Internal::MultiDurContext(mctx, handler, this);
+        out = Internal::MultiDurContext(mctx, handler, this, OpType::ENDURE);
     }
     return rv;
 }
 
+Internal::DurGroup&
+Client::_durgroup()
+{
+    if (!m_durgroup) {
+        m_durgroup.reset(new Internal::DurGroup(*this));
+    }
+    return *m_durgroup;
+}
+
 Status
 Client::mctx_observe(Handler *handler, Internal::MultiObsContext& out) {
     lcb_MULTICMD_CTX *mctx = lcb_observe3_ctxnew(m_instance);
-    out = Internal::MultiObsContext(mctx, handler, this);
+    out = Internal::MultiObsContext(mctx, handler, this, OpType::OBSERVE);
     return Status();
 }
 
 void
-GetResponse::handle_response(Client&, int, const lcb_RESPBASE *resp)
+GetResponse::handle_response(Client& client, int cbtype, const lcb_RESPBASE *resp)
 {
     u.resp = *(lcb_RESPGET *)resp;
+    m_resource = client.memory_resource();
+    m_replica = cbtype == LCB_CALLBACK_GETREPLICA;
+    m_inflation.reset();
+    if (status().success() && (u.resp.datatype & LCB_VALUE_F_SNAPPYCOMP)) {
+        if (client.m_inflating && client.m_inflating->source() == u.resp.value) {
+            m_inflation = client.m_inflating;
+        } else {
+            m_inflation = Internal::Inflation::create(
+                client.decompressor(), u.resp.value, u.resp.nvalue);
+        }
+    }
     if (status().success()) {
         if (u.resp.bufh) {
             lcb_backbuf_ref((lcb_BACKBUF) u.resp.bufh);
         } else if (u.resp.nvalue) {
-            char *tmp = new char[u.resp.nvalue + sizeof(size_t)];
-            u.resp.value = tmp;
-            size_t rc = 1;
-            memcpy(vbuf_refcnt(), &rc, sizeof rc);
+            std::shared_ptr<char> tmp = Internal::make_buffer(m_resource, u.resp.nvalue);
+            memcpy(tmp.get(), u.resp.value, u.resp.nvalue);
+            u.resp.value = tmp.get();
+            m_owned = std::move(tmp);
         }
     } else {
         u.resp.bufh = NULL;
         u.resp.value = NULL;
+        u.resp.nvalue = 0;
     }
 }
 
@@ -212,33 +801,189 @@ GetResponse::clear()
 {
     if (has_shared_buffer()) {
         lcb_backbuf_unref((lcb_BACKBUF)u.resp.bufh);
-    } else if (has_alloc_buffer()) {
-        size_t rc;
-        memcpy(&rc, vbuf_refcnt(), sizeof rc);
-        if (rc == 1) {
-            delete[] (char *)u.resp.value;
-        } else {
-            rc--;
-            memcpy(vbuf_refcnt(), &rc, sizeof rc);
-        }
     }
+    m_owned.reset();
+    m_inflation.reset();
     u.resp.value = NULL;
     u.resp.nvalue = 0;
     u.resp.bufh = NULL;
 }
 
-void GetResponse::assign_first(const GetResponse& other) {
+Buffer
+GetResponse::plain() const
+{
+    if (m_inflation) {
+        const std::shared_ptr<const char>& buf = m_inflation->inflate(
+            static_cast<const char*>(u.resp.value), u.resp.nvalue, m_resource);
+        if (buf) {
+            return Buffer(buf.get(), m_inflation->size());
+        }
+    }
+    return Buffer(static_cast<const char*>(u.resp.value), u.resp.nvalue);
+}
+
+void GetResponse::assign_shared(const GetResponse& other) {
     u.resp = other.u.resp;
+    m_owned = other.m_owned;
+    m_resource = other.m_resource;
+    m_replica = other.m_replica;
+    m_inflation = other.m_inflation;
     if (has_shared_buffer()) {
         lcb_backbuf_ref((lcb_BACKBUF)u.resp.bufh);
-    } else if (has_alloc_buffer()) {
-        size_t rc;
-        memcpy(&rc, vbuf_refcnt(), sizeof rc);
-        rc ++;
-        memcpy(vbuf_refcnt(), &rc, sizeof rc);
     }
 }
 
+void GetResponse::assign_move(GetResponse& other) {
+    u.resp = other.u.resp;
+    m_owned = std::move(other.m_owned);
+    m_resource = other.m_resource;
+    m_replica = other.m_replica;
+    m_inflation = std::move(other.m_inflation);
+    other.u.resp.value = NULL;
+    other.u.resp.nvalue = 0;
+    other.u.resp.bufh = NULL;
+}
+
+namespace Internal {
+void
+SubdocResults::load(lcb_RESPSUBDOC *resp)
+{
+    clear();
+    m_success = resp->rc == LCB_SUCCESS;
+    if (resp->bufh != NULL) {
+        m_bufh = static_cast<lcb_BACKBUF>(resp->bufh);
+        lcb_backbuf_ref(m_bufh);
+    }
+    lcb_SDENTRY ent;
+    size_t iter = 0;
+    while (lcb_sdresult_next(resp, &ent, &iter)) {
+        // Mutations only return entries for some paths; each says which
+        if (ent.index >= m_entries.size()) {
+            m_entries.resize(ent.index + 1);
+        }
+        m_entries[ent.index].value = Buffer(static_cast<const char*>(ent.value), ent.nvalue);
+        m_entries[ent.index].status = ent.status;
+    }
+    // The entries are only valid during the callback
+    resp->responses = NULL;
+    resp->bufh = NULL;
+}
+
+void
+SubdocResults::clear()
+{
+    if (m_bufh != NULL) {
+        lcb_backbuf_unref(m_bufh);
+        m_bufh = NULL;
+    }
+    m_entries.clear();
+}
+
+void
+SubdocResults::assign(const SubdocResults& other)
+{
+    m_entries = other.m_entries;
+    m_nspecs = other.m_nspecs;
+    m_success = other.m_success;
+    m_bufh = other.m_bufh;
+    if (m_bufh != NULL) {
+        lcb_backbuf_ref(m_bufh);
+    }
+}
+
+void
+SubdocResults::take(SubdocResults& other)
+{
+    m_entries = std::move(other.m_entries);
+    m_nspecs = other.m_nspecs;
+    m_success = other.m_success;
+    m_bufh = other.m_bufh;
+    other.m_bufh = NULL;
+    other.m_entries.clear();
+}
+} // namespace Internal
+
+void
+GetResponse::detatch()
+{
+    if (!has_shared_buffer()) {
+        return;
+    }
+    std::shared_ptr<char> tmp = Internal::make_buffer(m_resource, u.resp.nvalue);
+    memcpy(tmp.get(), u.resp.value, u.resp.nvalue);
+    lcb_backbuf_unref((lcb_BACKBUF)u.resp.bufh);
+    u.resp.bufh = NULL;
+    u.resp.value = tmp.get();
+    m_owned = std::move(tmp);
+}
+
+SharedValue
+GetResponse::shared_value() const
+{
+    SharedValue ret;
+    ret.m_value = value();
+    if (m_inflation && m_inflation->inflated()) {
+        ret.m_owned = m_inflation->buffer();
+        return ret;
+    }
+    ret.m_owned = m_owned;
+    if (has_shared_buffer()) {
+        ret.m_bufh = (lcb_BACKBUF)u.resp.bufh;
+        lcb_backbuf_ref(ret.m_bufh);
+    }
+    return ret;
+}
+
+SharedValue::SharedValue(const SharedValue& other)
+: m_value(other.m_value), m_bufh(other.m_bufh), m_owned(other.m_owned) {
+    if (m_bufh != NULL) {
+        lcb_backbuf_ref(m_bufh);
+    }
+}
+
+SharedValue::SharedValue(SharedValue&& other)
+: m_value(other.m_value), m_bufh(other.m_bufh), m_owned(std::move(other.m_owned)) {
+    other.m_bufh = NULL;
+    other.m_value = Buffer();
+}
+
+SharedValue&
+SharedValue::operator=(const SharedValue& other) {
+    if (this != &other) {
+        clear();
+        m_value = other.m_value;
+        m_bufh = other.m_bufh;
+        m_owned = other.m_owned;
+        if (m_bufh != NULL) {
+            lcb_backbuf_ref(m_bufh);
+        }
+    }
+    return *this;
+}
+
+SharedValue&
+SharedValue::operator=(SharedValue&& other) {
+    if (this != &other) {
+        clear();
+        m_value = other.m_value;
+        m_bufh = other.m_bufh;
+        m_owned = std::move(other.m_owned);
+        other.m_bufh = NULL;
+        other.m_value = Buffer();
+    }
+    return *this;
+}
+
+void
+SharedValue::clear() {
+    if (m_bufh != NULL) {
+        lcb_backbuf_unref(m_bufh);
+        m_bufh = NULL;
+    }
+    m_owned.reset();
+    m_value = Buffer();
+}
+
 void
 StatsResponse::handle_response(Client& c, int t, const lcb_RESPBASE *resp)
 {
@@ -309,10 +1054,16 @@ GetResponse::GetResponse() : Response() {
     u.resp.nvalue = 0;
 }
 
+GetResponse::GetResponse(GetResponse&& other) : Response() {
+    assign_move(other);
+}
+
 GetResponse&
-GetResponse::operator=(const GetResponse& other) {
-    clear();
-    assign_first(other);
+GetResponse::operator=(GetResponse&& other) {
+    if (this != &other) {
+        clear();
+        assign_move(other);
+    }
     return *this;
 }
 
@@ -321,16 +1072,6 @@ GetResponse::has_shared_buffer() const {
     return u.resp.bufh != NULL && u.resp.value != NULL;
 }
 
-bool
-GetResponse::has_alloc_buffer() const {
-    return u.resp.bufh == NULL && u.resp.value != NULL;
-}
-
-char *
-GetResponse::vbuf_refcnt() {
-    return const_cast<char*>(valuebuf()) + valuesize();
-}
-
 void
 GetResponse::value(std::string& s) const {
     if (status()) {
@@ -353,29 +1094,20 @@ DurableResponse<T>::handle_response(Client& client, int cbtype, const lcb_RESPBA
         // Meaning we're in the initial operation phase:
         m_op.handle_response(client, cbtype, rb);
         assert(m_op.done());
-        Status status;
-        EndureContext dctx(client, m_dur, this, status);
-        if (!status) {
-            dur_bail(status);
-            return;
-        }
-        EndureCommand dCmd(static_cast<const char*>(rb->key), rb->nkey, rb->cas);
-        status = dctx.add(dCmd);
-        if (!status) {
-            dur_bail(status);
-            return;
-        }
-        client.enter();
-        status = dctx.submit();
+        Status status = m_op.status();
         if (!status) {
-            client.fail();
             dur_bail(status);
             return;
         }
-        client.leave();
+        // The check's response is delivered to whichever handler the
+        // library knows this operation by, so that any handler interposed
+        // by the client sees the operation complete
+        client._durgroup().add(static_cast<const char*>(rb->key), rb->nkey, rb->cas,
+            Internal::token_of(m_op), *m_duropt, reinterpret_cast<Handler*>(rb->cookie));
         m_state = State::SUBMIT;
     } else {
         m_dur.handle_response(client, cbtype, rb);
+        m_state = State::DONE;
     }
 }
 
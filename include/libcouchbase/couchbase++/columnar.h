@@ -0,0 +1,415 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_COLUMNAR_H
+#define LCB_PLUSPLUS_COLUMNAR_H
+
+#include <libcouchbase/couchbase++/query.h>
+#include <cmath>
+
+namespace Couchbase {
+
+//! @brief The columns to extract from each row of a ColumnarQuery
+class ColumnSchema {
+public:
+    enum Type { INT, DOUBLE, BOOL, STRING };
+
+    //! @brief Add a column
+    //! @param name the name of the row's (top-level) member
+    //! @param type how the value is stored
+    ColumnSchema& add(const std::string& name, Type type) {
+        m_names.push_back(name);
+        m_types.push_back(type);
+        return *this;
+    }
+
+    size_t size() const { return m_names.size(); }
+    const std::string& name(size_t ix) const { return m_names[ix]; }
+    Type type(size_t ix) const { return m_types[ix]; }
+
+private:
+    std::vector<std::string> m_names;
+    std::vector<Type> m_types;
+};
+
+namespace Internal { class ColumnDecoder; }
+
+//! @brief A batch of query rows, stored column by column
+//! @details
+//! Each column is a contiguous array with one entry per row. Numeric and
+//! boolean columns are plain arrays; string columns are a single data
+//! buffer plus an array of `size() + 1` offsets into it, so that row `i`
+//! occupies `[offsets[i], offsets[i+1])`.
+//!
+//! A value which is missing, `null`, or of the wrong type for its column is
+//! marked invalid and stored as 0 (or an empty string). `INT` columns only
+//! accept numbers with an integral value (so `2.5` is invalid, while `2.0`
+//! and `2e3` are not); integers beyond the range of `int64_t` saturate.
+//! String columns hold the raw JSON of non-string values, and the decoded
+//! text of strings.
+class ColumnBatch {
+public:
+    struct Column {
+        ColumnSchema::Type type;
+        std::vector<int64_t> ints;
+        std::vector<double> doubles;
+        std::vector<uint8_t> bools;
+        std::vector<uint32_t> offsets;
+        std::string data;
+        //! 1 if the row's value is present, 0 otherwise
+        std::vector<uint8_t> valid;
+    };
+
+    //! Number of rows in the batch
+    size_t size() const { return m_nrows; }
+    //! Number of columns, in schema order
+    size_t columns() const { return m_columns.size(); }
+    const Column& column(size_t ix) const { return m_columns[ix]; }
+
+    const int64_t *ints(size_t col) const { return m_columns[col].ints.data(); }
+    const double *doubles(size_t col) const { return m_columns[col].doubles.data(); }
+    const uint8_t *bools(size_t col) const { return m_columns[col].bools.data(); }
+    const uint8_t *valid(size_t col) const { return m_columns[col].valid.data(); }
+
+    //! Get the value of a string column for a given row
+    Buffer string(size_t col, size_t row) const {
+        const Column& c = m_columns[col];
+        return Buffer(c.data.data() + c.offsets[row], c.offsets[row + 1] - c.offsets[row]);
+    }
+
+    //! Approximate memory used by the batch's values
+    size_t bytes() const { return m_bytes; }
+
+private:
+    friend class Internal::ColumnDecoder;
+    inline void init(const ColumnSchema& schema, size_t capacity);
+    inline void add_null(size_t col);
+    inline void add_value(size_t col, const JsonView& v);
+    static inline bool integral(const JsonView& v, int64_t& out);
+    inline void end_row();
+
+    std::vector<Column> m_columns;
+    size_t m_nrows = 0;
+    size_t m_bytes = 0;
+};
+
+namespace Internal {
+//! @private
+//! Decodes rows into the columns of a ColumnBatch
+class ColumnDecoder {
+public:
+    ColumnDecoder(const ColumnSchema& schema) : m_schema(schema), m_seen(schema.size()) {}
+    const ColumnSchema& schema() const { return m_schema; }
+
+    //! Empty a batch and make room for `capacity` rows
+    void reset(ColumnBatch& batch, size_t capacity) const { batch.init(m_schema, capacity); }
+
+    //! Append a row to a batch. Columns missing from the row (or all of
+    //! them, if it is not an object) are added as invalid
+    inline void decode(const JsonView& row, ColumnBatch& batch);
+
+private:
+    inline size_t find(const Buffer& name, size_t expect) const;
+    ColumnSchema m_schema;
+    std::vector<uint8_t> m_seen;
+};
+} // namespace Internal
+
+/**
+ * Query which accumulates its rows into column-oriented batches, for
+ * analytical processing of large results.
+ *
+ * Each row is decoded as it is received, directly from the library's
+ * buffer, into the current batch. No QueryRow is kept for it and its
+ * payload is never copied. Iteration yields a batch at a time, once it is
+ * full or the query has completed.
+ *
+ * @code{c++}
+ * ColumnSchema schema;
+ * schema.add("country", ColumnSchema::STRING).add("stops", ColumnSchema::INT);
+ * ColumnarQuery q(client, cmd, schema, status);
+ * for (auto& batch : q) {
+ *     const int64_t *stops = batch.ints(1);
+ *     const uint8_t *valid = batch.valid(1);
+ *     for (size_t ii = 0; ii < batch.size(); ii++) {
+ *         total += stops[ii] * valid[ii];
+ *     }
+ * }
+ * @endcode
+ *
+ * buffer_limit() counts batches rather than rows.
+ */
+class ColumnarQuery : public CallbackQuery, protected Internal::RowProvider<ColumnBatch> {
+public:
+    /**
+     * @param client Client handle
+     * @param cmd Command containing the statement
+     * @param schema the columns to extract from each row
+     * @param[out] status will contain an error if the query could not be issued
+     * @param batch_rows the number of rows in each batch. The last batch
+     *        may be smaller
+     */
+    inline ColumnarQuery(Client& client, QueryCommand& cmd, const ColumnSchema& schema,
+        Status& status, size_t batch_rows = 4096);
+
+    /**
+     * @param client Client handle
+     * @param cmd a prepared statement with its parameters bound
+     * @param schema the columns to extract from each row
+     * @param[out] status will contain an error if the query could not be issued
+     * @param batch_rows the number of rows in each batch
+     */
+    inline ColumnarQuery(Client& client, const PreparedCommand& cmd, const ColumnSchema& schema,
+        Status& status, size_t batch_rows = 4096);
+
+    typedef Internal::RowIterator<ColumnBatch> const_iterator;
+    const_iterator begin() { return rp_begin(); }
+    const_iterator end() { return rp_end(); }
+    const QueryMeta& meta() const { return m_meta; }
+    Status status() const { return m_meta.status(); }
+    const ColumnSchema& schema() const { return m_decoder.schema(); }
+
+    using Internal::RowProvider<ColumnBatch>::buffer_limit;
+    using Internal::RowProvider<ColumnBatch>::rows_buffered;
+    using Internal::RowProvider<ColumnBatch>::bytes_buffered;
+
+protected:
+    bool rp_active() const override { return active(); }
+    void rp_wait() override { m_cli.wait(); }
+    size_t rp_size(const ColumnBatch& batch) const override { return batch.bytes(); }
+
+private:
+    inline void handle_row(QueryRow&& row);
+    inline void handle_done(QueryMeta&& meta);
+    inline void flush();
+
+    Internal::ColumnDecoder m_decoder;
+    ColumnBatch m_batch;
+    QueryMeta m_meta;
+    size_t m_batchrows;
+};
+
+void
+ColumnBatch::init(const ColumnSchema& schema, size_t capacity)
+{
+    m_columns.clear();
+    m_columns.resize(schema.size());
+    m_nrows = 0;
+    m_bytes = 0;
+    for (size_t ii = 0; ii < schema.size(); ii++) {
+        Column& c = m_columns[ii];
+        c.type = schema.type(ii);
+        c.valid.reserve(capacity);
+        switch (c.type) {
+        case ColumnSchema::INT:
+            c.ints.reserve(capacity);
+            break;
+        case ColumnSchema::DOUBLE:
+            c.doubles.reserve(capacity);
+            break;
+        case ColumnSchema::BOOL:
+            c.bools.reserve(capacity);
+            break;
+        case ColumnSchema::STRING:
+            c.offsets.reserve(capacity + 1);
+            c.offsets.push_back(0);
+            break;
+        }
+    }
+}
+
+void
+ColumnBatch::add_null(size_t col)
+{
+    Column& c = m_columns[col];
+    c.valid.push_back(0);
+    switch (c.type) {
+    case ColumnSchema::INT:
+        c.ints.push_back(0);
+        break;
+    case ColumnSchema::DOUBLE:
+        c.doubles.push_back(0);
+        break;
+    case ColumnSchema::BOOL:
+        c.bools.push_back(0);
+        break;
+    case ColumnSchema::STRING:
+        c.offsets.push_back(static_cast<uint32_t>(c.data.size()));
+        break;
+    }
+}
+
+bool
+ColumnBatch::integral(const JsonView& v, int64_t& out)
+{
+    Buffer raw = v.raw();
+    bool plain = true;
+    for (size_t ii = 0; ii < raw.size() && plain; ii++) {
+        char c = raw.data()[ii];
+        plain = c != '.' && c != 'e' && c != 'E';
+    }
+    if (plain) {
+        out = v.as_int();
+        return true;
+    }
+    // Fraction or exponent: only integral values within range are accepted
+    double d = v.as_double();
+    if (d != std::floor(d) || !(d >= -9223372036854775808.0 && d < 9223372036854775808.0)) {
+        return false;
+    }
+    out = static_cast<int64_t>(d);
+    return true;
+}
+
+void
+ColumnBatch::add_value(size_t col, const JsonView& v)
+{
+    Column& c = m_columns[col];
+    JsonView::Type t = v.type();
+    switch (c.type) {
+    case ColumnSchema::INT:
+    case ColumnSchema::DOUBLE:
+        if (t != JsonView::NUMBER) {
+            add_null(col);
+            return;
+        }
+        if (c.type == ColumnSchema::INT) {
+            int64_t n;
+            if (!integral(v, n)) {
+                add_null(col);
+                return;
+            }
+            c.ints.push_back(n);
+        } else {
+            c.doubles.push_back(v.as_double());
+        }
+        m_bytes += 8;
+        break;
+    case ColumnSchema::BOOL:
+        if (t != JsonView::BOOLEAN) {
+            add_null(col);
+            return;
+        }
+        c.bools.push_back(v.as_bool());
+        m_bytes += 1;
+        break;
+    case ColumnSchema::STRING:
+        if (t == JsonView::NUL || t == JsonView::INVALID) {
+            add_null(col);
+            return;
+        }
+        if (t != JsonView::STRING) {
+            c.data.append(v.raw().data(), v.raw().size());
+        } else if (v.has_escapes()) {
+            c.data.append(v.as_string());
+        } else {
+            c.data.append(v.as_buffer().data(), v.as_buffer().size());
+        }
+        m_bytes += c.data.size() - c.offsets.back() + 4;
+        c.offsets.push_back(static_cast<uint32_t>(c.data.size()));
+        break;
+    }
+    c.valid.push_back(1);
+}
+
+void
+ColumnBatch::end_row()
+{
+    m_nrows++;
+}
+
+ColumnarQuery::ColumnarQuery(Client& client, QueryCommand& cmd, const ColumnSchema& schema,
+    Status& status, size_t batch_rows)
+: CallbackQuery(client, cmd, status,
+    [this](QueryRow&& row, CallbackQuery*){ handle_row(std::move(row)); },
+    [this](QueryMeta&& meta, CallbackQuery*){ handle_done(std::move(meta)); }),
+  m_decoder(schema), m_batchrows(batch_rows ? batch_rows : 1)
+{
+    m_decoder.reset(m_batch, m_batchrows);
+}
+
+ColumnarQuery::ColumnarQuery(Client& client, const PreparedCommand& cmd, const ColumnSchema& schema,
+    Status& status, size_t batch_rows)
+: CallbackQuery(client, cmd, status,
+    [this](QueryRow&& row, CallbackQuery*){ handle_row(std::move(row)); },
+    [this](QueryMeta&& meta, CallbackQuery*){ handle_done(std::move(meta)); }),
+  m_decoder(schema), m_batchrows(batch_rows ? batch_rows : 1)
+{
+    m_decoder.reset(m_batch, m_batchrows);
+}
+
+namespace Internal {
+size_t
+ColumnDecoder::find(const Buffer& name, size_t expect) const
+{
+    size_t ncols = m_schema.size();
+    for (size_t ii = 0; ii < ncols; ii++) {
+        // Rows usually list their members in the same order as the
+        // schema, so start looking at the column after the last match
+        size_t ix = (expect + ii) % ncols;
+        const std::string& s = m_schema.name(ix);
+        if (s.size() == name.size() && memcmp(s.data(), name.data(), s.size()) == 0) {
+            return ix;
+        }
+    }
+    return ncols;
+}
+
+void
+ColumnDecoder::decode(const JsonView& row, ColumnBatch& batch)
+{
+    size_t ncols = m_schema.size();
+    size_t expect = 0;
+    std::fill(m_seen.begin(), m_seen.end(), 0);
+    for (auto& member : row) {
+        size_t ix = find(member.name, expect);
+        if (ix == ncols || m_seen[ix]) {
+            continue;
+        }
+        m_seen[ix] = 1;
+        batch.add_value(ix, member.value);
+        expect = ix + 1;
+    }
+    for (size_t ii = 0; ii < ncols; ii++) {
+        if (!m_seen[ii]) {
+            batch.add_null(ii);
+        }
+    }
+    batch.end_row();
+}
+} // namespace Internal
+
+void
+ColumnarQuery::handle_row(QueryRow&& row)
+{
+    // Rows are decoded straight from the library's buffer; nothing is
+    // detached
+    m_decoder.decode(row.view(), m_batch);
+    if (m_batch.size() >= m_batchrows) {
+        flush();
+    }
+}
+
+void
+ColumnarQuery::handle_done(QueryMeta&& meta)
+{
+    m_meta = std::move(meta);
+    if (m_batch.size()) {
+        rp_add(std::move(m_batch));
+    }
+    m_cli.breakout();
+}
+
+void
+ColumnarQuery::flush()
+{
+    bool full = rp_add(std::move(m_batch));
+    m_batch = ColumnBatch();
+    m_decoder.reset(m_batch, m_batchrows);
+    m_cli.breakout(full);
+}
+
+} // namespace Couchbase
+
+#endif
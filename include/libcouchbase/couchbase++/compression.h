@@ -0,0 +1,128 @@
+#ifndef LCB_PLUSPLUS_COMPRESSION_H
+#define LCB_PLUSPLUS_COMPRESSION_H
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+
+#ifdef LCB_CXX_SNAPPY
+#include <snappy-c.h>
+#endif
+
+namespace Couchbase {
+
+//! Where the library compresses and decompresses values (with Snappy).
+//! See Client::compression()
+enum class Compression {
+    //! Values are never compressed
+    NONE = LCB_COMPRESS_NONE,
+    //! Compressed values received from the server are decompressed as they
+    //! are received
+    IN = LCB_COMPRESS_IN,
+    //! Stored values are compressed if the server supports it. Values are
+    //! received as they are stored, so they may arrive compressed
+    OUT = LCB_COMPRESS_OUT,
+    //! Both #IN and #OUT
+    INOUT = LCB_COMPRESS_INOUT,
+    //! Compress stored values even if the server has not said it supports
+    //! compression
+    FORCE = LCB_COMPRESS_FORCE
+};
+
+//! @brief Decompresses values received compressed
+//! @details
+//! When installed with Client::decompressor(), a @ref GetResponse whose
+//! value arrived compressed keeps the compressed bytes, and only inflates
+//! them (into a buffer from the client's MemoryResource) the first time the
+//! value is accessed. Values which are never read are never decompressed.
+//! Copies of a response, such as ReadCache hits, share the decompressed
+//! value rather than each making their own.
+class Decompressor {
+public:
+    virtual ~Decompressor() {}
+
+    //! @brief Get the size of the uncompressed data
+    //! @return false if the input is not valid
+    virtual bool uncompressed_length(const char *in, size_t nin, size_t& nout) const = 0;
+
+    //! @brief Decompress data
+    //! @param out a buffer of the size returned by #uncompressed_length()
+    //! @return false if the input is not valid
+    virtual bool decompress(const char *in, size_t nin, char *out, size_t nout) const = 0;
+};
+
+#ifdef LCB_CXX_SNAPPY
+//! @brief Decompressor using the Snappy library
+//! @details
+//! Available when `LCB_CXX_SNAPPY` is defined, in which case the
+//! application must also link against Snappy.
+class SnappyDecompressor : public Decompressor {
+public:
+    bool uncompressed_length(const char *in, size_t nin, size_t& nout) const override {
+        return snappy_uncompressed_length(in, nin, &nout) == SNAPPY_OK;
+    }
+    bool decompress(const char *in, size_t nin, char *out, size_t nout) const override {
+        return snappy_uncompress(in, nin, out, &nout) == SNAPPY_OK;
+    }
+};
+#endif
+
+namespace Internal {
+//! @private
+//! The decompressed copy of a value. Every response holding the value
+//! (including ReadCache hits and coalesced gets) shares one, so the value is
+//! decompressed at most once, by whichever thread reads it first.
+class Inflation {
+public:
+    Inflation(const Decompressor *d, const void *source, size_t size)
+    : m_decomp(d), m_source(source), m_size(size) {}
+
+    //! @return NULL if the value is not valid compressed data
+    static std::shared_ptr<Inflation> create(const Decompressor *d, const void *value, size_t nvalue) {
+        size_t n = 0;
+        if (d == NULL || !d->uncompressed_length(static_cast<const char*>(value), nvalue, n)) {
+            return std::shared_ptr<Inflation>();
+        }
+        return std::make_shared<Inflation>(d, value, n);
+    }
+
+    //! The value as received, to recognise other responses carrying it
+    const void *source() const { return m_source; }
+
+    //! The size of the decompressed value
+    size_t size() const { return m_size; }
+
+    //! Whether the value has been decompressed successfully
+    bool inflated() const { return m_ready.load(std::memory_order_acquire) && m_buf; }
+
+    //! The decompressed value; only set once #inflated() is true
+    const std::shared_ptr<const char>& buffer() const { return m_buf; }
+
+    //! Decompress the value, unless that was done already
+    //! @return the decompressed value, or NULL if it could not be
+    const std::shared_ptr<const char>& inflate(const char *in, size_t nin, MemoryResource *resource) {
+        if (!m_ready.load(std::memory_order_acquire)) {
+            std::call_once(m_once, [&]() {
+                std::shared_ptr<char> tmp = make_buffer(resource, m_size ? m_size : 1);
+                if (m_decomp->decompress(in, nin, tmp.get(), m_size)) {
+                    m_buf = std::move(tmp);
+                }
+                m_ready.store(true, std::memory_order_release);
+            });
+        }
+        return m_buf;
+    }
+
+private:
+    const Decompressor *m_decomp;
+    const void *m_source;
+    size_t m_size;
+    std::once_flag m_once;
+    std::atomic<bool> m_ready { false };
+    std::shared_ptr<const char> m_buf;
+};
+} // namespace Internal
+
+} // namespace Couchbase
+
+#endif
@@ -35,6 +35,161 @@ EndureContext::submit() {
     }
     return st;
 }
+
+namespace Internal {
+
+//! @private
+//! A multi-key durability check shared by several operations. The response
+//! for each key is re-dispatched, with the requesting handler as its cookie,
+//! through Client::_dispatch() so each operation is completed normally. The
+//! check counts as one outstanding operation per key.
+class DurRound : public Handler {
+public:
+    struct Waiter {
+        Handler *handler;
+        uint64_t cas;
+        MutationToken token;
+    };
+
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        lcb_RESPENDURE resp = *reinterpret_cast<const lcb_RESPENDURE*>(rb);
+        auto ii = waiters.find(std::string(static_cast<const char*>(rb->key), rb->nkey));
+        if (ii == waiters.end()) {
+            return;
+        }
+        resp.cookie = ii->second.handler;
+        waiters.erase(ii);
+        client._dispatch(cbtype, reinterpret_cast<const lcb_RESPBASE*>(&resp));
+    }
+
+    bool done() const override { return true; }
+    void finish() override {
+        if (waiters.empty()) {
+            delete this;
+        }
+    }
+
+    std::unordered_map<std::string, Waiter> waiters;
+};
+
+extern "C" {
+static void durtimer(lcb_timer_t timer, lcb_t, const void *cookie);
 }
 
+//! @private
+//! Collects durability checks as their mutations complete, and submits
+//! them in groups (one per set of options) once the client's durability
+//! window elapses.
+class DurGroup {
+public:
+    DurGroup(Client& client) : m_client(client) {}
+
+    ~DurGroup() {
+        if (m_timer != NULL) {
+            lcb_timer_destroy(m_client.handle(), m_timer);
+        }
+        for (auto& p : m_pending) {
+            delete p.second;
+        }
+    }
+
+    //! Queue a durability check. Its response is dispatched to `handler`
+    void add(const char *key, size_t nkey, uint64_t cas, const MutationToken *token,
+        const DurabilityOptions& options, Handler *handler) {
+        std::string k(key, nkey);
+        DurRound *round = find(options);
+        if (round->waiters.count(k)) {
+            // The same key may only appear once in a check
+            flush();
+            round = find(options);
+        }
+        DurRound::Waiter w = { handler, cas, token ? *token : MutationToken() };
+        round->waiters[k] = w;
+
+        if (m_timer == NULL) {
+            lcb_error_t err = LCB_SUCCESS;
+            m_timer = lcb_timer_create(m_client.handle(), this,
+                m_client.durability_window(), 0, durtimer, &err);
+            if (err != LCB_SUCCESS) {
+                m_timer = NULL;
+                flush();
+            }
+        }
+    }
+
+    //! Submit all queued checks
+    void flush() {
+        if (m_timer != NULL) {
+            lcb_timer_destroy(m_client.handle(), m_timer);
+            m_timer = NULL;
+        }
+        std::vector<std::pair<DurabilityOptions, DurRound*>> pending;
+        pending.swap(m_pending);
+        for (auto& p : pending) {
+            submit(p.first, p.second);
+        }
+    }
+
+private:
+    DurGroup(const DurGroup&) = delete;
+    DurGroup& operator=(const DurGroup&) = delete;
+
+    DurRound *find(const DurabilityOptions& options) {
+        for (auto& p : m_pending) {
+            if (memcmp(static_cast<const lcb_durability_opts_t*>(&p.first),
+                    static_cast<const lcb_durability_opts_t*>(&options),
+                    sizeof(lcb_durability_opts_t)) == 0) {
+                return p.second;
+            }
+        }
+        m_pending.push_back(std::make_pair(options, new DurRound()));
+        return m_pending.back().second;
+    }
+
+    void submit(const DurabilityOptions& options, DurRound *round) {
+        MultiDurContext ctx;
+        Status st = m_client.mctx_endure(options, round, ctx);
+        for (auto ii = round->waiters.begin(); st && ii != round->waiters.end(); ++ii) {
+            EndureCommand cmd(ii->first.data(), ii->first.size(), ii->second.cas);
+            if (ii->second.token.valid()) {
+                cmd.mutation_token(&ii->second.token);
+            }
+            st = ctx.add(&cmd);
+        }
+        if (st) {
+            st = ctx.done();
+        }
+        if (st) {
+            m_client.remaining += round->waiters.size();
+            return;
+        }
+        ctx.bail();
+
+        // Fail each operation through the normal dispatch path
+        std::unique_ptr<DurRound> guard(round);
+        for (auto& w : round->waiters) {
+            lcb_RESPENDURE resp;
+            memset(&resp, 0, sizeof resp);
+            resp.cookie = w.second.handler;
+            resp.key = w.first.data();
+            resp.nkey = w.first.size();
+            resp.rc = st;
+            m_client._dispatch(LCB_CALLBACK_ENDURE, reinterpret_cast<const lcb_RESPBASE*>(&resp));
+        }
+    }
+
+    Client& m_client;
+    lcb_timer_t m_timer = NULL;
+    std::vector<std::pair<DurabilityOptions, DurRound*>> m_pending;
+};
+
+extern "C" {
+static void durtimer(lcb_timer_t, lcb_t, const void *cookie) {
+    const_cast<DurGroup*>(reinterpret_cast<const DurGroup*>(cookie))->flush();
+}
+}
+
+} // namespace Internal
+} // namespace Couchbase
+
 #endif
@@ -7,8 +7,16 @@ class Status;
 class Context;
 class DurabilityOptions;
 class Handler;
+class ReadCache;
 class Status;
 
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#define LCB_CXX_HAVE_COROUTINES 1
+template <typename T, typename R> class Awaitable;
+#endif
+#endif
+
 namespace Internal {
     template <typename T> class MultiContextT;
     template<typename T> using MultiContext = MultiContextT<T>;
@@ -25,6 +33,10 @@ struct Get {
     typedef lcb_CMDGET CType;
     typedef lcb_RESPGET RType;
 };
+struct GetReplica {
+    typedef lcb_CMDGETREPLICA CType;
+    typedef lcb_RESPGET RType;
+};
 struct Store {
     typedef lcb_CMDSTORE CType;
     typedef lcb_RESPSTORE RType;
@@ -57,5 +69,13 @@ struct Endure {
     typedef lcb_CMDENDURE CType;
     typedef lcb_RESPENDURE RType;
 };
+struct SubdocLookup {
+    typedef lcb_CMDSUBDOC CType;
+    typedef lcb_RESPSUBDOC RType;
+};
+struct SubdocMutate {
+    typedef lcb_CMDSUBDOC CType;
+    typedef lcb_RESPSUBDOC RType;
+};
 }
 }
@@ -0,0 +1,136 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_JSONVIEW_H
+#define LCB_PLUSPLUS_JSONVIEW_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace Couchbase {
+
+//! @brief Lazy, zero-copy view over a JSON document
+//! @details
+//! A JsonView does not parse its input up front. Looking up a member or an
+//! array element scans the text only as far as needed, skipping over nested
+//! values without building any intermediate structures, and the returned
+//! views point into the original buffer. This makes it cheap to extract a
+//! handful of fields from each row of a large result set:
+//!
+//! @code{c++}
+//! for (auto& row : query) {
+//!     JsonView v = row.view();
+//!     int64_t count = v["count"].as_int();
+//!     Buffer country = v["country"].as_buffer();
+//! }
+//! @endcode
+//!
+//! The view is only valid for as long as the buffer it refers to. Input is
+//! assumed to be well formed (as returned by the server); malformed input
+//! yields invalid views rather than undefined behavior.
+class JsonView {
+public:
+    enum Type { INVALID, NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    class const_iterator;
+
+    JsonView() {}
+    JsonView(const Buffer& buf) { assign(buf.data(), buf.data() + buf.size()); }
+    JsonView(const char *begin, const char *end) { assign(begin, end); }
+
+    //! The type of the value
+    Type type() const { return m_type; }
+    bool valid() const { return m_type != INVALID; }
+    bool is_null() const { return m_type == NUL; }
+
+    //! The raw JSON text for this value
+    Buffer raw() const { return Buffer(m_begin, m_end - m_begin); }
+
+    //! @brief Look up an object member by name
+    //! @return the member's value, or an invalid view if this is not an object
+    //!         or has no such member
+    inline JsonView get(const char *name, size_t nname) const;
+    JsonView operator[](const char *name) const { return get(name, strlen(name)); }
+    JsonView operator[](const std::string& name) const { return get(name.c_str(), name.size()); }
+
+    //! @brief Look up an array element by position
+    //! @return the element, or an invalid view if out of range
+    inline JsonView operator[](size_t index) const;
+    JsonView operator[](int index) const { return (*this)[static_cast<size_t>(index)]; }
+
+    //! Number of members (or elements). This scans the whole value.
+    inline size_t size() const;
+
+    //! Iterate over the members of an object or the elements of an array
+    inline const_iterator begin() const;
+    inline const_iterator end() const;
+
+    //! @param def returned if the value is not a boolean
+    bool as_bool(bool def = false) const {
+        return m_type == BOOLEAN ? *m_begin == 't' : def;
+    }
+    //! @param def returned if the value is not a number
+    inline int64_t as_int(int64_t def = 0) const;
+    //! @param def returned if the value is not a number
+    inline double as_double(double def = 0) const;
+
+    //! @brief Get the contents of a string without copying
+    //! Escape sequences are not processed (see #has_escapes())
+    //! @return the characters between the quotes; empty if not a string
+    Buffer as_buffer() const {
+        if (m_type != STRING) {
+            return Buffer();
+        }
+        return Buffer(m_begin + 1, m_end - m_begin - 2);
+    }
+
+    //! Whether the string contains escape sequences, in which case
+    //! #as_string() should be used rather than #as_buffer()
+    bool has_escapes() const {
+        Buffer b = as_buffer();
+        return !b.empty() && memchr(b.data(), '\\', b.size()) != NULL;
+    }
+
+    //! Get the contents of a string with escape sequences decoded
+    inline std::string as_string() const;
+
+private:
+    inline void assign(const char *begin, const char *end);
+    const char *m_begin = NULL;
+    const char *m_end = NULL;
+    Type m_type = INVALID;
+};
+
+//! A member of an object, or element of an array (in which case the name
+//! is empty)
+struct JsonMember {
+    Buffer name; //!< Raw name, without quotes. Escapes are not processed
+    JsonView value;
+};
+
+class JsonView::const_iterator {
+public:
+    const JsonMember& operator*() const { return m_cur; }
+    const JsonMember* operator->() const { return &m_cur; }
+    inline const_iterator& operator++();
+    bool operator==(const const_iterator& o) const { return m_pos == o.m_pos; }
+    bool operator!=(const const_iterator& o) const { return m_pos != o.m_pos; }
+private:
+    friend class JsonView;
+    const_iterator(const char *pos, const char *end, bool obj)
+    : m_end(end), m_object(obj) { load(pos); }
+    inline void load(const char *pos);
+    const char *m_pos = NULL;
+    const char *m_next = NULL;
+    const char *m_end;
+    bool m_object;
+    JsonMember m_cur;
+};
+
+} // namespace Couchbase
+
+#include <libcouchbase/couchbase++/jsonview.inl.h>
+
+#endif
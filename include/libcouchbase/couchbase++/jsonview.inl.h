@@ -0,0 +1,339 @@
+namespace Couchbase {
+namespace Internal {
+namespace Json {
+
+inline const char *
+skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+// Skip a string starting at the opening quote. Returns the position after
+// the closing quote, or NULL if the string is not terminated.
+inline const char *
+skip_string(const char *p, const char *end) {
+    ++p;
+    for (;;) {
+        const char *q = static_cast<const char*>(memchr(p, '"', end - p));
+        if (q == NULL) {
+            return NULL;
+        }
+        // The quote is escaped if preceded by an odd number of backslashes
+        size_t nslash = 0;
+        for (const char *b = q - 1; b >= p && *b == '\\'; --b) {
+            ++nslash;
+        }
+        if (nslash % 2 == 0) {
+            return q + 1;
+        }
+        p = q + 1;
+    }
+}
+
+// Skip over a single value. Returns the position after the value, or NULL
+// if malformed.
+inline const char *
+skip_value(const char *p, const char *end) {
+    if (p >= end) {
+        return NULL;
+    }
+    if (*p == '"') {
+        return skip_string(p, end);
+    }
+    if (*p == '{' || *p == '[') {
+        size_t depth = 0;
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                p = skip_string(p, end);
+                if (p == NULL) {
+                    return NULL;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    return p + 1;
+                }
+            }
+            ++p;
+        }
+        return NULL;
+    }
+    // Scalar: runs until a delimiter
+    const char *start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+            *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+        ++p;
+    }
+    return p == start ? NULL : p;
+}
+
+inline void
+append_utf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Convert to an integer, saturating rather than overflowing
+inline int64_t
+clamp_int(double d) {
+    if (d != d) {
+        return 0;
+    }
+    if (d >= 9223372036854775807.0) {
+        return INT64_MAX;
+    }
+    if (d <= -9223372036854775808.0) {
+        return INT64_MIN;
+    }
+    return static_cast<int64_t>(d);
+}
+
+// Whether [begin, end) is exactly `lit`
+inline bool
+is_literal(const char *begin, const char *end, const char *lit, size_t n) {
+    return static_cast<size_t>(end - begin) == n && memcmp(begin, lit, n) == 0;
+}
+
+inline unsigned long
+parse_hex4(const char *p) {
+    char tmp[5];
+    memcpy(tmp, p, 4);
+    tmp[4] = '\0';
+    return strtoul(tmp, NULL, 16);
+}
+
+} // namespace Json
+} // namespace Internal
+
+void
+JsonView::assign(const char *begin, const char *end) {
+    using namespace Internal::Json;
+    m_type = INVALID;
+    begin = skip_ws(begin, end);
+    if (begin == NULL || begin >= end) {
+        return;
+    }
+    const char *vend = skip_value(begin, end);
+    if (vend == NULL) {
+        return;
+    }
+    m_begin = begin;
+    m_end = vend;
+    switch (*begin) {
+    case '{': m_type = OBJECT; break;
+    case '[': m_type = ARRAY; break;
+    case '"': m_type = STRING; break;
+    case 't':
+        m_type = is_literal(begin, vend, "true", 4) ? BOOLEAN : INVALID;
+        break;
+    case 'f':
+        m_type = is_literal(begin, vend, "false", 5) ? BOOLEAN : INVALID;
+        break;
+    case 'n':
+        m_type = is_literal(begin, vend, "null", 4) ? NUL : INVALID;
+        break;
+    default:
+        m_type = (*begin == '-' || (*begin >= '0' && *begin <= '9')) ? NUMBER : INVALID;
+        break;
+    }
+}
+
+void
+JsonView::const_iterator::load(const char *pos) {
+    using namespace Internal::Json;
+    m_pos = m_end;
+    m_cur = JsonMember();
+    const char *p = skip_ws(pos, m_end);
+    if (p >= m_end || *p == '}' || *p == ']') {
+        return;
+    }
+    if (m_object) {
+        if (*p != '"') {
+            return;
+        }
+        const char *kend = skip_string(p, m_end);
+        if (kend == NULL) {
+            return;
+        }
+        m_cur.name = Buffer(p + 1, kend - p - 2);
+        p = skip_ws(kend, m_end);
+        if (p >= m_end || *p != ':') {
+            return;
+        }
+        p = skip_ws(p + 1, m_end);
+    }
+    const char *vend = skip_value(p, m_end);
+    if (vend == NULL) {
+        return;
+    }
+    m_cur.value = JsonView(p, vend);
+    m_pos = pos;
+    vend = skip_ws(vend, m_end);
+    m_next = (vend < m_end && *vend == ',') ? vend + 1 : m_end;
+}
+
+JsonView::const_iterator&
+JsonView::const_iterator::operator++() {
+    load(m_next);
+    return *this;
+}
+
+JsonView::const_iterator
+JsonView::begin() const {
+    if (m_type != OBJECT && m_type != ARRAY) {
+        return end();
+    }
+    return const_iterator(m_begin + 1, m_end - 1, m_type == OBJECT);
+}
+
+JsonView::const_iterator
+JsonView::end() const {
+    // An exhausted iterator's position is the end of its container's
+    // contents (just before the closing bracket)
+    const char *e = (m_type == OBJECT || m_type == ARRAY) ? m_end - 1 : m_end;
+    return const_iterator(e, e, false);
+}
+
+JsonView
+JsonView::get(const char *name, size_t nname) const {
+    if (m_type != OBJECT) {
+        return JsonView();
+    }
+    for (const_iterator ii = begin(), ee = end(); ii != ee; ++ii) {
+        if (ii->name.size() == nname && memcmp(ii->name.data(), name, nname) == 0) {
+            return ii->value;
+        }
+    }
+    return JsonView();
+}
+
+JsonView
+JsonView::operator[](size_t index) const {
+    if (m_type != ARRAY) {
+        return JsonView();
+    }
+    for (const_iterator ii = begin(), ee = end(); ii != ee; ++ii) {
+        if (index-- == 0) {
+            return ii->value;
+        }
+    }
+    return JsonView();
+}
+
+size_t
+JsonView::size() const {
+    size_t n = 0;
+    for (const_iterator ii = begin(), ee = end(); ii != ee; ++ii) {
+        ++n;
+    }
+    return n;
+}
+
+int64_t
+JsonView::as_int(int64_t def) const {
+    if (m_type != NUMBER) {
+        return def;
+    }
+    const char *p = m_begin;
+    bool neg = false;
+    if (*p == '-') {
+        neg = true;
+        ++p;
+    }
+    // The magnitude of INT64_MIN is one more than INT64_MAX
+    const uint64_t limit = neg ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+    uint64_t v = 0;
+    for (; p < m_end; ++p) {
+        unsigned digit = static_cast<unsigned>(*p - '0');
+        if (digit > 9 || v > (limit - digit) / 10) {
+            // Fractional or exponent notation, or out of range
+            return Internal::Json::clamp_int(as_double(static_cast<double>(def)));
+        }
+        v = v * 10 + digit;
+    }
+    if (!neg || v == 0) {
+        return static_cast<int64_t>(v);
+    }
+    return -static_cast<int64_t>(v - 1) - 1;
+}
+
+double
+JsonView::as_double(double def) const {
+    if (m_type != NUMBER) {
+        return def;
+    }
+    char tmp[64];
+    size_t n = m_end - m_begin;
+    if (n < sizeof tmp) {
+        memcpy(tmp, m_begin, n);
+        tmp[n] = '\0';
+        return strtod(tmp, NULL);
+    }
+    return strtod(std::string(m_begin, n).c_str(), NULL);
+}
+
+std::string
+JsonView::as_string() const {
+    Buffer b = as_buffer();
+    std::string out;
+    out.reserve(b.size());
+    const char *p = b.data(), *end = b.data() + b.size();
+    while (p < end) {
+        const char *q = static_cast<const char*>(memchr(p, '\\', end - p));
+        if (q == NULL) {
+            out.append(p, end);
+            break;
+        }
+        out.append(p, q);
+        if (q + 1 >= end) {
+            break;
+        }
+        p = q + 2;
+        switch (q[1]) {
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+            if (end - p < 4) {
+                return out;
+            }
+            unsigned long cp = Internal::Json::parse_hex4(p);
+            p += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                unsigned long lo = Internal::Json::parse_hex4(p + 2);
+                if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    p += 6;
+                }
+            }
+            Internal::Json::append_utf8(out, cp);
+            break;
+        }
+        default: out += q[1]; break;
+        }
+    }
+    return out;
+}
+
+} // namespace Couchbase
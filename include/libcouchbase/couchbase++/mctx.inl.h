@@ -7,8 +7,8 @@ MultiContextT<T>::MultiContextT()
 }
 
 template<typename T>
-MultiContextT<T>::MultiContextT(lcb_MULTICMD_CTX *c, Handler *handler, Client *cli)
-: m_inner(c), cookie(handler), client(cli) {
+MultiContextT<T>::MultiContextT(lcb_MULTICMD_CTX *c, Handler *handler, Client *cli, OpType type)
+: m_inner(c), cookie(handler), client(cli), m_type(type) {
 }
 
 template <typename T> MultiContextT<T>&
@@ -17,6 +17,8 @@ MultiContextT<T>::operator=(MultiContextT<T>&& other) {
     m_inner = other.m_inner;
     cookie = other.cookie;
     client = other.client;
+    m_type = other.m_type;
+    m_count = other.m_count;
     other.m_inner = NULL;
     return *this;
 }
@@ -28,15 +30,27 @@ MultiContextT<T>::~MultiContextT() {
 
 template <typename T> Status
 MultiContextT<T>::add(const T* cmd) {
-    return m_inner->addcmd(m_inner, reinterpret_cast<const lcb_CMDBASE*>(cmd));
+    Status st = m_inner->addcmd(m_inner, reinterpret_cast<const lcb_CMDBASE*>(cmd));
+    if (st) {
+        m_count++;
+    }
+    return st;
 }
 
 template <typename T> Status
 MultiContextT<T>::done() {
+    Handler *handler = cookie;
+    Internal::Metrics *metrics = client->_metrics();
+    if (metrics && m_count) {
+        handler = metrics->wrap(m_type, cookie, m_count);
+    }
     client->enter();
-    Status s = m_inner->done(m_inner, cookie->as_cookie());
+    Status s = m_inner->done(m_inner, handler->as_cookie());
     if (!s) {
         client->fail();
+        if (handler != cookie) {
+            metrics->release(static_cast<TimedOp*>(handler));
+        }
     } else {
         client->leave();
     }
@@ -0,0 +1,166 @@
+#ifndef LCB_PLUSPLUS_MEMORY_H
+#define LCB_PLUSPLUS_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <memory>
+#include <vector>
+
+namespace Couchbase {
+
+//! @brief Source of memory for buffers allocated by the library
+//! @details
+//! This follows the interface of C++17's `std::pmr::memory_resource`. A
+//! resource may be installed on a @ref Client via Client::memory_resource(),
+//! after which buffers holding response data (detached query and view rows,
+//! copied values and batch response lists) are allocated from it.
+class MemoryResource {
+public:
+    virtual ~MemoryResource() {}
+
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        return do_allocate(bytes, alignment);
+    }
+    void deallocate(void *p, size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        do_deallocate(p, bytes, alignment);
+    }
+
+protected:
+    virtual void *do_allocate(size_t bytes, size_t alignment) = 0;
+    virtual void do_deallocate(void *p, size_t bytes, size_t alignment) = 0;
+};
+
+namespace Internal {
+class NewDeleteResource : public MemoryResource {
+protected:
+    void *do_allocate(size_t bytes, size_t) override {
+        return ::operator new(bytes);
+    }
+    void do_deallocate(void *p, size_t, size_t) override {
+        ::operator delete(p);
+    }
+};
+}
+
+//! Get the default memory resource, which uses global `new` and `delete`
+inline MemoryResource *default_resource() {
+    static Internal::NewDeleteResource instance;
+    return &instance;
+}
+
+//! @brief Memory resource which releases all its memory at once
+//! @details
+//! Allocations are carved sequentially out of large blocks obtained from an
+//! upstream resource. Deallocation is a no-op; memory is only returned when
+//! #release() is called or the resource is destroyed. This is useful for
+//! scoping all response memory for a single request:
+//!
+//! @code{c++}
+//! MonotonicResource arena;
+//! client.memory_resource(&arena);
+//! ... issue queries, consume rows ...
+//! client.memory_resource(NULL);
+//! // all rows are gone; free everything in one go
+//! arena.release();
+//! @endcode
+//!
+//! @warning The resource must outlive all objects allocated from it.
+class MonotonicResource : public MemoryResource {
+public:
+    //! @param blocksize the minimum size of each block requested upstream
+    //! @param upstream where to obtain blocks from
+    MonotonicResource(size_t blocksize = 64 * 1024,
+        MemoryResource *upstream = default_resource())
+    : m_blocksize(blocksize), m_upstream(upstream) {}
+
+    ~MonotonicResource() { release(); }
+
+    //! Return all memory to the upstream resource
+    void release() {
+        for (auto& b : m_blocks) {
+            m_upstream->deallocate(b.first, b.second);
+        }
+        m_blocks.clear();
+        m_cur = NULL;
+        m_left = 0;
+    }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        size_t pad = m_cur ? (alignment - reinterpret_cast<uintptr_t>(m_cur) % alignment) % alignment : 0;
+        if (m_cur == NULL || pad + bytes > m_left) {
+            size_t n = bytes + alignment > m_blocksize ? bytes + alignment : m_blocksize;
+            m_cur = static_cast<char*>(m_upstream->allocate(n));
+            m_blocks.push_back(std::make_pair(m_cur, n));
+            m_left = n;
+            pad = (alignment - reinterpret_cast<uintptr_t>(m_cur) % alignment) % alignment;
+        }
+        char *ret = m_cur + pad;
+        m_cur = ret + bytes;
+        m_left -= pad + bytes;
+        return ret;
+    }
+    void do_deallocate(void *, size_t, size_t) override {}
+
+private:
+    MonotonicResource(MonotonicResource&) = delete;
+    MonotonicResource& operator=(MonotonicResource&) = delete;
+    size_t m_blocksize;
+    MemoryResource *m_upstream;
+    std::vector<std::pair<char*, size_t>> m_blocks;
+    char *m_cur = NULL;
+    size_t m_left = 0;
+};
+
+namespace Internal {
+
+//! @private
+//! Standard allocator drawing from a MemoryResource
+template <typename T>
+class ResourceAllocator {
+public:
+    typedef T value_type;
+    ResourceAllocator(MemoryResource *r = default_resource()) : m_resource(r) {}
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U>& other) : m_resource(other.resource()) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T*>(m_resource->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p, size_t n) {
+        m_resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+    MemoryResource *resource() const { return m_resource; }
+
+    template <typename U>
+    bool operator==(const ResourceAllocator<U>& other) const { return m_resource == other.resource(); }
+    template <typename U>
+    bool operator!=(const ResourceAllocator<U>& other) const { return m_resource != other.resource(); }
+
+private:
+    MemoryResource *m_resource;
+};
+
+//! @private
+//! Allocate a shared character buffer (and its control block) from a
+//! resource.
+inline std::shared_ptr<char>
+make_buffer(MemoryResource *resource, size_t size) {
+    struct Deleter {
+        MemoryResource *resource;
+        size_t size;
+        void operator()(char *p) { resource->deallocate(p, size, 1); }
+    };
+    if (resource == NULL) {
+        resource = default_resource();
+    }
+    char *p = static_cast<char*>(resource->allocate(size ? size : 1, 1));
+    Deleter d = { resource, size ? size : 1 };
+    return std::shared_ptr<char>(p, d, ResourceAllocator<char>(resource));
+}
+
+} // namespace Internal
+} // namespace Couchbase
+
+#endif
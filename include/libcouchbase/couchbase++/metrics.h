@@ -0,0 +1,133 @@
+#ifndef LCB_PLUSPLUS_METRICS_H
+#define LCB_PLUSPLUS_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Couchbase {
+
+//! Types of operations for which latencies are recorded.
+//! See Client::latency()
+enum class OpType {
+    GET, STORE, TOUCH, REMOVE, UNLOCK, COUNTER, STATS, OBSERVE, ENDURE, N1QL, VIEW,
+    GET_REPLICA, LOOKUP_IN, MUTATE_IN,
+    _MAX
+};
+
+//! @brief Histogram of operation latencies
+//! @details
+//! Latencies are recorded in nanoseconds into log-linear buckets: each power
+//! of two is split into 16 sub-buckets, so any reported value is within
+//! about 6% of the true value. Recording is a single relaxed atomic
+//! increment, and the histogram may be read from another thread while it is
+//! being recorded into.
+class LatencyHistogram {
+public:
+    LatencyHistogram() { reset(); }
+
+    //! Record a single latency
+    void record(uint64_t ns) {
+        m_buckets[index(ns)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! Number of latencies recorded
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    //! @brief Get the latency at a given percentile
+    //! @param pct the percentile, between 0 and 100
+    //! @return the latency in nanoseconds (the upper bound of the bucket in
+    //!         which the percentile falls), or 0 if nothing was recorded
+    uint64_t percentile(double pct) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(pct / 100.0 * total + 0.5);
+        if (target == 0) {
+            target = 1;
+        }
+        uint64_t seen = 0;
+        for (size_t ii = 0; ii < NBUCKETS; ii++) {
+            seen += m_buckets[ii].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                return upper_bound(ii);
+            }
+        }
+        return upper_bound(NBUCKETS - 1);
+    }
+
+    uint64_t p50() const { return percentile(50); }
+    uint64_t p99() const { return percentile(99); }
+    uint64_t p999() const { return percentile(99.9); }
+
+    //! Discard all recorded latencies
+    void reset() {
+        for (size_t ii = 0; ii < NBUCKETS; ii++) {
+            m_buckets[ii].store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // Values below 2^SUBBITS are stored exactly; above that, each power of
+    // two has 2^SUBBITS buckets. Values beyond 2^MAXBITS ns (~18 minutes)
+    // land in the last bucket.
+    static const unsigned SUBBITS = 4;
+    static const unsigned MAXBITS = 40;
+    static const size_t NBUCKETS = (MAXBITS - SUBBITS + 1) << SUBBITS;
+
+    static unsigned msb(uint64_t v) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#else
+        unsigned n = 0;
+        while (v >>= 1) {
+            n++;
+        }
+        return n;
+#endif
+    }
+
+    static size_t index(uint64_t v) {
+        if (v < (1u << SUBBITS)) {
+            return static_cast<size_t>(v);
+        }
+        unsigned shift = msb(v) - SUBBITS;
+        size_t ix = ((shift + 1) << SUBBITS) + ((v >> shift) & ((1u << SUBBITS) - 1));
+        return ix < NBUCKETS ? ix : NBUCKETS - 1;
+    }
+
+    static uint64_t upper_bound(size_t ix) {
+        if (ix < (1u << SUBBITS)) {
+            return ix;
+        }
+        unsigned shift = static_cast<unsigned>(ix >> SUBBITS) - 1;
+        uint64_t sub = (ix & ((1u << SUBBITS) - 1)) | (1u << SUBBITS);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::atomic<uint64_t> m_buckets[NBUCKETS];
+    std::atomic<uint64_t> m_count;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+};
+
+namespace Internal {
+class Metrics;
+class TimedOp;
+
+inline uint64_t
+now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename T> struct OpTypeOf;
+} // namespace Internal
+} // namespace Couchbase
+
+#endif
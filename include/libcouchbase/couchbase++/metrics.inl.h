@@ -0,0 +1,86 @@
+namespace Couchbase {
+namespace Internal {
+
+template <> struct OpTypeOf<OpInfo::Get> { static const OpType value = OpType::GET; };
+template <> struct OpTypeOf<OpInfo::GetReplica> { static const OpType value = OpType::GET_REPLICA; };
+template <> struct OpTypeOf<OpInfo::Store> { static const OpType value = OpType::STORE; };
+template <> struct OpTypeOf<OpInfo::Touch> { static const OpType value = OpType::TOUCH; };
+template <> struct OpTypeOf<OpInfo::Remove> { static const OpType value = OpType::REMOVE; };
+template <> struct OpTypeOf<OpInfo::Unlock> { static const OpType value = OpType::UNLOCK; };
+template <> struct OpTypeOf<OpInfo::Counter> { static const OpType value = OpType::COUNTER; };
+template <> struct OpTypeOf<OpInfo::Stats> { static const OpType value = OpType::STATS; };
+template <> struct OpTypeOf<OpInfo::Observe> { static const OpType value = OpType::OBSERVE; };
+template <> struct OpTypeOf<OpInfo::Endure> { static const OpType value = OpType::ENDURE; };
+template <> struct OpTypeOf<OpInfo::SubdocLookup> { static const OpType value = OpType::LOOKUP_IN; };
+template <> struct OpTypeOf<OpInfo::SubdocMutate> { static const OpType value = OpType::MUTATE_IN; };
+
+//! @private
+//! Handler interposed between the library and an operation's own handler
+//! while latency metrics are enabled. Records the time from scheduling to
+//! the final response of each of its commands.
+class TimedOp : public Handler {
+public:
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        target->handle_response(client, cbtype, rb);
+    }
+    bool done() const override { return target->done(); }
+    inline void finish() override;
+
+    Handler *target = NULL;
+    Metrics *metrics = NULL;
+    TimedOp *next = NULL;
+    uint64_t start = 0;
+    size_t pending = 0;
+    OpType type = OpType::GET;
+};
+
+//! @private
+class Metrics {
+public:
+    LatencyHistogram histograms[static_cast<size_t>(OpType::_MAX)];
+
+    void record(OpType type, uint64_t start) {
+        histograms[static_cast<size_t>(type)].record(now_ns() - start);
+    }
+
+    //! Wrap a handler which will receive `ncmds` operations
+    TimedOp *wrap(OpType type, Handler *target, size_t ncmds) {
+        TimedOp *op = m_free;
+        if (op != NULL) {
+            m_free = op->next;
+        } else {
+            m_all.push_back(std::unique_ptr<TimedOp>(new TimedOp()));
+            op = m_all.back().get();
+        }
+        op->target = target;
+        op->metrics = this;
+        op->type = type;
+        op->pending = ncmds;
+        op->start = now_ns();
+        return op;
+    }
+
+    void release(TimedOp *op) {
+        op->next = m_free;
+        m_free = op;
+    }
+
+private:
+    // Owns every wrapper ever created. Wrappers of operations which are
+    // dropped (e.g. by Context::bail()) are released by the client
+    std::vector<std::unique_ptr<TimedOp>> m_all;
+    TimedOp *m_free = NULL;
+};
+
+void
+TimedOp::finish() {
+    metrics->record(type, start);
+    Handler *h = target;
+    if (--pending == 0) {
+        metrics->release(this);
+    }
+    h->finish();
+}
+
+} // namespace Internal
+} // namespace Couchbase
@@ -0,0 +1,126 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_POOL_H
+#define LCB_PLUSPLUS_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace Couchbase {
+
+//! @brief Fixed-size pool of @ref Client objects for multi-threaded use.
+//! @details
+//! A single Client wraps a single `lcb_t` and is therefore not thread safe.
+//! The pool owns a number of independent clients (all connected to the same
+//! bucket) and hands them out to threads via #acquire(). The returned
+//! @ref Lease gives the calling thread exclusive use of one client and
+//! returns it to the pool when destroyed.
+//!
+//! Checking a client out and returning it does not take any locks unless
+//! every client is in use, in which case #acquire() blocks until one is
+//! released.
+//!
+//! @code{c++}
+//! ClientPool pool(8, "couchbase://localhost/default");
+//! if (!pool.connect()) { ... }
+//!
+//! // From any thread:
+//! ClientPool::Lease client = pool.acquire();
+//! auto resp = client->get("foo");
+//! @endcode
+class ClientPool {
+public:
+    //! @brief Exclusive handle to one client of the pool.
+    //! The client is returned to the pool when the lease is destroyed.
+    class Lease {
+    public:
+        Lease() {}
+        Lease(Lease&& other) : m_pool(other.m_pool), m_index(other.m_index) {
+            other.m_pool = NULL;
+        }
+        Lease& operator=(Lease&& other) {
+            release();
+            m_pool = other.m_pool;
+            m_index = other.m_index;
+            other.m_pool = NULL;
+            return *this;
+        }
+        ~Lease() { release(); }
+
+        Client& operator*() const { return *m_pool->m_clients[m_index]; }
+        Client* operator->() const { return m_pool->m_clients[m_index].get(); }
+
+        //! Whether this lease holds a client
+        bool valid() const { return m_pool != NULL; }
+
+        //! Return the client to the pool before the lease is destroyed
+        inline void release();
+
+    private:
+        friend class ClientPool;
+        Lease(ClientPool *pool, size_t index) : m_pool(pool), m_index(index) {}
+        Lease(Lease&) = delete;
+        Lease& operator=(Lease&) = delete;
+        ClientPool *m_pool = NULL;
+        size_t m_index = 0;
+    };
+
+    //! @brief Create the pool
+    //! @param count the number of clients to create. This is typically the
+    //!        number of threads which will be using the pool concurrently.
+    //! @param connstr the connection string, as in Client::Client()
+    //! @param passwd the bucket password, as in Client::Client()
+    //! @param username the username, as in Client::Client()
+    //! @note The clients are not connected until #connect() is called.
+    inline ClientPool(size_t count,
+        const std::string& connstr = "couchbase://localhost/default",
+        const std::string& passwd = "", const std::string& username = "");
+
+    //! @brief Bootstrap all clients in the pool
+    //! @return the first error encountered, or success if all clients
+    //!         connected.
+    inline Status connect();
+
+    //! @brief Check out a client, blocking until one is available
+    //! @return a lease for the client
+    inline Lease acquire();
+
+    //! @brief Check out a client, if one is available
+    //! @param[out] lease populated with a client on success
+    //! @return true if a client was checked out, false if all are in use
+    inline bool try_acquire(Lease& lease);
+
+    //! Get the number of clients in the pool
+    size_t size() const { return m_clients.size(); }
+
+private:
+    inline bool try_checkout(size_t& index);
+    inline void checkin(size_t index);
+
+    // Each busy flag is padded out to its own cache line so that threads
+    // checking out neighbouring clients do not contend with each other.
+    struct Slot {
+        std::atomic<bool> busy;
+        char pad[64 - sizeof(std::atomic<bool>)];
+        Slot() : busy(false) {}
+    };
+
+    std::vector<std::unique_ptr<Client>> m_clients;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<size_t> m_next;
+    std::atomic<size_t> m_waiters;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+
+    ClientPool(ClientPool&) = delete;
+    ClientPool& operator=(ClientPool&) = delete;
+};
+
+} // namespace Couchbase
+
+#include <libcouchbase/couchbase++/pool.inl.h>
+
+#endif
@@ -0,0 +1,100 @@
+namespace Couchbase {
+
+ClientPool::ClientPool(size_t count, const std::string& connstr,
+    const std::string& passwd, const std::string& username)
+: m_next(0), m_waiters(0)
+{
+    if (count == 0) {
+        throw Status(LCB_EINVAL);
+    }
+    m_slots.reset(new Slot[count]);
+    m_clients.reserve(count);
+    for (size_t ii = 0; ii < count; ii++) {
+        m_clients.emplace_back(new Client(connstr, passwd, username));
+    }
+}
+
+Status
+ClientPool::connect()
+{
+    for (auto& client : m_clients) {
+        Status rv = client->connect();
+        if (!rv) {
+            return rv;
+        }
+    }
+    return Status();
+}
+
+bool
+ClientPool::try_checkout(size_t& index)
+{
+    // Start at a different slot for each caller so that concurrent callers
+    // spread out instead of all racing for the first free slot.
+    size_t n = m_clients.size();
+    size_t start = m_next.fetch_add(1, std::memory_order_relaxed);
+    for (size_t ii = 0; ii < n; ii++) {
+        size_t cur = (start + ii) % n;
+        std::atomic<bool>& busy = m_slots[cur].busy;
+        if (busy.load()) {
+            continue;
+        }
+        bool expected = false;
+        if (busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            index = cur;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+ClientPool::checkin(size_t index)
+{
+    m_slots[index].busy.store(false);
+    if (m_waiters.load() != 0) {
+        // Take the lock so that the notification cannot slip in between a
+        // waiter's failed checkout and its call to wait()
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_cond.notify_one();
+    }
+}
+
+bool
+ClientPool::try_acquire(Lease& lease)
+{
+    size_t index;
+    if (!try_checkout(index)) {
+        return false;
+    }
+    lease = Lease(this, index);
+    return true;
+}
+
+ClientPool::Lease
+ClientPool::acquire()
+{
+    size_t index;
+    if (try_checkout(index)) {
+        return Lease(this, index);
+    }
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_waiters.fetch_add(1);
+    while (!try_checkout(index)) {
+        m_cond.wait(guard);
+    }
+    m_waiters.fetch_sub(1);
+    return Lease(this, index);
+}
+
+void
+ClientPool::Lease::release()
+{
+    if (m_pool != NULL) {
+        m_pool->checkin(m_index);
+        m_pool = NULL;
+    }
+}
+
+} // namespace Couchbase
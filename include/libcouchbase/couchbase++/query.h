@@ -1,4 +1,15 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_QUERY_H
+#define LCB_PLUSPLUS_QUERY_H
+
+#include <deque>
 #include <libcouchbase/n1ql.h>
+#include <libcouchbase/couchbase++/row_common.h>
+#include <libcouchbase/couchbase++/jsonview.h>
+
 namespace Couchbase {
 namespace Internal {
 extern "C" { static void n1qlcb(lcb_t,int,const lcb_RESPN1QL*); }
@@ -53,6 +64,112 @@ private:
     bool m_adhoc = true;
 };
 
+/**
+ * A request to execute a prepared statement with a given set of parameters.
+ * This is obtained from PreparedQuery::bind() and may be passed to a
+ * Query or CallbackQuery in place of a QueryCommand.
+ */
+class PreparedCommand {
+public:
+    /**
+     * Get the encoded request body
+     * @return the JSON body sent to the query service
+     */
+    const std::string& body() const { return m_body; }
+private:
+    friend class PreparedQuery;
+    std::string m_body;
+};
+
+/**
+ * A statement which has been prepared once and may then be executed any
+ * number of times, varying only its positional parameters.
+ *
+ * The query plan returned by the server is stored with the object. Each
+ * execution sends the plan directly, so the statement is never prepared
+ * again. The fixed part of the request body is encoded once at
+ * construction, and binding parameters only appends them to a copy of it.
+ *
+ * The plan is never refreshed. If the server no longer accepts it (for
+ * example after an index it uses was dropped or rebuilt, or the query node
+ * was restarted), executions fail with a "prepared statement not found" or
+ * "plan invalid" error in their QueryMeta. The statement must then be
+ * prepared again by constructing a new PreparedQuery.
+ *
+ * @code{c++}
+ * Status st;
+ * PreparedQuery pq(client, "SELECT * FROM `travel-sample` WHERE country=$1 LIMIT $2", st);
+ * PreparedCommand cmd;
+ * for (auto& country : countries) {
+ *     pq.bind(cmd, "\"" + country + "\"", "10");
+ *     Query q(client, cmd, st);
+ *     for (auto& row : q) { ... }
+ * }
+ * @endcode
+ */
+class PreparedQuery {
+public:
+    /**
+     * Prepare a statement. This performs the `PREPARE` request and waits for
+     * it to complete.
+     * @param client the client to prepare with
+     * @param statement the N1QL statement. Positional placeholders (`$1`,
+     *        `$2`, ...) are filled in at execution time
+     * @param[out] status the result of preparing the statement
+     */
+    inline PreparedQuery(Client& client, const std::string& statement, Status& status);
+    PreparedQuery() {}
+
+    /**
+     * Whether the statement was prepared successfully
+     */
+    bool valid() const { return !m_prefix.empty(); }
+
+    /**
+     * Bind positional parameters, producing a request ready for execution.
+     * @param cmd the request to fill in. Its buffer is reused, so binding
+     *        into the same object repeatedly does not allocate
+     * @param args the parameters. Each must be a JSON-encoded value and
+     *        may be a `std::string`, `const char*` or Buffer
+     */
+    template <typename ...Args>
+    void bind(PreparedCommand& cmd, const Args&... args) const {
+        begin_args(cmd);
+        add_args(cmd, args...);
+        end_args(cmd);
+    }
+
+    /**
+     * Bind positional parameters from a vector
+     * @see bind()
+     */
+    inline void bind(PreparedCommand& cmd, const std::vector<std::string>& args) const;
+
+private:
+    inline void begin_args(PreparedCommand& cmd) const;
+    inline void end_args(PreparedCommand& cmd) const;
+    inline void add_arg(PreparedCommand& cmd, const char *s, size_t n) const;
+    void add_args(PreparedCommand&) const {}
+    template <typename ...Args>
+    void add_args(PreparedCommand& cmd, const std::string& arg, const Args&... rest) const {
+        add_arg(cmd, arg.c_str(), arg.size());
+        add_args(cmd, rest...);
+    }
+    template <typename ...Args>
+    void add_args(PreparedCommand& cmd, const char *arg, const Args&... rest) const {
+        add_arg(cmd, arg, strlen(arg));
+        add_args(cmd, rest...);
+    }
+    template <typename ...Args>
+    void add_args(PreparedCommand& cmd, const Buffer& arg, const Args&... rest) const {
+        add_arg(cmd, arg.data(), arg.size());
+        add_args(cmd, rest...);
+    }
+
+    // The encoded body up to (but excluding) the arguments
+    std::string m_prefix;
+};
+
 /**
  * A single row in a query result
  */
@@ -67,14 +184,28 @@ public:
     /**
      * Makes the buffer scoped to the row itself. Useful if you wish to persist
      * the row data outside the callback (if using callback rows)
+     * @param resource where to allocate the row's copy from. If `NULL`, the
+     * default resource is used.
+     */
+    inline void detatch(MemoryResource *resource = NULL);
+
+    //! @private
+    //! Detach the row into a shared slab
+    inline void detatch(Internal::RowSlab& slab, MemoryResource *resource);
+
+    /**
+     * Get a lazy view over the row's JSON, for reading individual fields
+     * without copying or fully parsing the row.
+     * @return a view which is valid for as long as #json() is
      */
-    inline void detatch();
+    JsonView view() const { return JsonView(m_row); }
 
     operator std::string() const { return m_row.to_string(); }
 private:
     friend class CallbackQuery;
     friend class Query;
-    QueryRow(const lcb_RESPN1QL *);
+    inline QueryRow(const lcb_RESPN1QL *);
+    inline void detatch_to(std::shared_ptr<char>&& buf);
     Buffer m_row;
     std::shared_ptr<char> m_buf;
 };
@@ -148,6 +279,18 @@ public:
     inline CallbackQuery(Client& cli, QueryCommand& cmd, Status& status,
         RowCallback rowcb, DoneCallback donecb);
 
+    /**
+     * Execute a prepared statement
+     * @param cli the client handle
+     * @param cmd the request, obtained from PreparedQuery::bind(). This need
+     *        not remain valid after the constructor returns
+     * @param[out] status if an error happens during query construction, it is indicated here
+     * @param rowcb the callback to be invoked for each row
+     * @param donecb the callback to be invoked once all rows are done
+     */
+    inline CallbackQuery(Client& cli, const PreparedCommand& cmd, Status& status,
+        RowCallback rowcb, DoneCallback donecb);
+
     /**
      * Check if the query is still ongoing
      * @return true if there is more data to fetch, false otherwise
@@ -165,11 +308,13 @@ public:
 protected:
     Client& m_cli;
 private:
+    inline void issue(lcb_CMDN1QL& cmd, Status& status);
     CallbackQuery(const CallbackQuery&) = delete;
     CallbackQuery& operator=(const CallbackQuery& other) = delete;
     RowCallback m_rowcb = NULL;
     DoneCallback m_donecb = NULL;
     bool m_done = false;
+    uint64_t m_start = 0;
 
 };
 
@@ -190,21 +335,143 @@ public:
      */
     inline Query(Client& client, QueryCommand& cmd, Status& status);
 
+    /**
+     * @param client Client handle
+     * @param cmd a prepared statement with its parameters bound
+     * @param[out] status will contain an error if the query could not be issued
+     */
+    inline Query(Client& client, const PreparedCommand& cmd, Status& status);
+
     typedef Internal::RowIterator<QueryRow> const_iterator;
     const_iterator begin() { return rp_begin(); }
     const_iterator end() { return rp_end(); }
     const QueryMeta& meta() const { return m_meta; }
     Status status() const { return m_meta.status(); }
 
+    using Internal::RowProvider<QueryRow>::buffer_limit;
+    using Internal::RowProvider<QueryRow>::rows_buffered;
+    using Internal::RowProvider<QueryRow>::bytes_buffered;
+
     inline static QueryMeta execute(Client& client, const std::string& stmt);
 
 protected:
     bool rp_active() const override { return active(); }
     void rp_wait() override { m_cli.wait(); }
+    size_t rp_size(const QueryRow& row) const override { return row.json().size(); }
 private:
+    inline void handle_row(QueryRow&&);
+    inline void handle_done(QueryMeta&&);
     QueryMeta m_meta;
 };
 
+/**
+ * Runs several queries concurrently on one client, and iterates over their
+ * rows as a single stream.
+ *
+ * All queries are issued as they are added, and their rows are received in
+ * parallel while the group is iterated. By default rows are yielded in the
+ * order they arrive. If a comparison function is given, each query's rows
+ * are assumed to already be sorted by it, and the group yields a k-way merge
+ * of them in sorted order.
+ *
+ * When merging, rows held back until every query has produced its next row
+ * count against buffer_limit() as well, and the event loop is stopped when
+ * they reach it. All queries share the client's event loop, so memory stays
+ * bounded only while each query keeps producing rows: if one query stalls,
+ * rows of the others accumulate until it catches up.
+ *
+ * @code{c++}
+ * QueryGroup group(client, [](const QueryRow& a, const QueryRow& b) {
+ *     return a.view()["ts"].as_int() < b.view()["ts"].as_int();
+ * });
+ * for (auto& stmt : shards) {
+ *     QueryCommand cmd(stmt);
+ *     group.add(cmd);
+ * }
+ * for (auto& row : group) { ... }
+ * for (size_t ii = 0; ii < group.size(); ii++) {
+ *     std::cout << group.meta(ii).status() << std::endl;
+ * }
+ * @endcode
+ */
+class QueryGroup : protected Internal::RowProvider<QueryRow> {
+public:
+    //! Returns true if the first row sorts before the second
+    typedef std::function<bool(const QueryRow&, const QueryRow&)> Compare;
+
+    /**
+     * @param client the client to run the queries on
+     * @param compare if set, merge the (individually sorted) results of
+     *        each query into a single sorted stream
+     */
+    inline QueryGroup(Client& client, Compare compare = NULL);
+
+    /**
+     * Issue a query as part of the group
+     * @return the status of issuing the query. Queries which fail to be
+     *         issued are not part of the group
+     */
+    inline Status add(QueryCommand& cmd);
+    inline Status add(const PreparedCommand& cmd);
+
+    typedef Internal::RowIterator<QueryRow> const_iterator;
+    const_iterator begin() { return rp_begin(); }
+    const_iterator end() { return rp_end(); }
+
+    using Internal::RowProvider<QueryRow>::buffer_limit;
+
+    //! Number of rows received but not yet consumed, including those held
+    //! back for merging
+    size_t rows_buffered() const { return RowProvider::rows_buffered() + m_heldrows; }
+    //! Size of the rows received but not yet consumed, including those held
+    //! back for merging
+    size_t bytes_buffered() const { return RowProvider::bytes_buffered() + m_heldbytes; }
+
+    //! Whether any query is still receiving rows
+    bool active() const { return m_pending > 0; }
+    //! Number of queries in the group
+    size_t size() const { return m_members.size(); }
+    /**
+     * Get the metadata for a query, in the order the queries were added.
+     * Only valid once that query has completed
+     */
+    const QueryMeta& meta(size_t index) const { return m_members[index]->meta; }
+    //! The first failure among the queries, or success
+    inline Status status() const;
+
+protected:
+    bool rp_active() const override { return active(); }
+    void rp_wait() override { m_cli.wait(); }
+    size_t rp_size(const QueryRow& row) const override { return row.json().size(); }
+
+private:
+    struct Member {
+        std::unique_ptr<CallbackQuery> query;
+        std::deque<QueryRow> rows;
+        QueryMeta meta;
+        bool done = false;
+    };
+
+    template <typename C> inline Status issue(C& cmd);
+    inline void handle_row(Member& m, QueryRow&& row);
+    inline void handle_done(Member& m, QueryMeta&& meta);
+    inline void merge();
+
+    QueryGroup(const QueryGroup&) = delete;
+    QueryGroup& operator=(const QueryGroup&) = delete;
+
+    Client& m_cli;
+    Compare m_compare;
+    std::vector<std::unique_ptr<Member>> m_members;
+    size_t m_pending = 0;
+    bool m_full = false;
+    // Rows in the members' queues, waiting to be merged
+    size_t m_heldrows = 0;
+    size_t m_heldbytes = 0;
+};
+
 }
 
 #include <libcouchbase/couchbase++/query.inl.h>
+
+#endif
@@ -62,15 +62,26 @@ QueryRow::QueryRow(const lcb_RESPN1QL *resp) {
 }
 
 void
-QueryRow::detatch() {
+QueryRow::detatch(MemoryResource *resource) {
     if (m_buf == NULL && !m_row.empty()) {
-        char *tmp = new char[m_row.size()];
-        m_buf.reset(tmp, std::default_delete<char[]>());
-        memcpy(tmp, m_row.data(), m_row.size());
-        m_row = Buffer(tmp, m_row.size());
+        detatch_to(Internal::make_buffer(resource, m_row.size()));
     }
 }
 
+void
+QueryRow::detatch(Internal::RowSlab& slab, MemoryResource *resource) {
+    if (m_buf == NULL && !m_row.empty()) {
+        detatch_to(slab.allocate(resource, m_row.size()));
+    }
+}
+
+void
+QueryRow::detatch_to(std::shared_ptr<char>&& buf) {
+    m_buf = std::move(buf);
+    memcpy(m_buf.get(), m_row.data(), m_row.size());
+    m_row = Buffer(m_buf.get(), m_row.size());
+}
+
 namespace Internal {
 extern "C" {
 static void n1qlcb(lcb_t, int, const lcb_RESPN1QL *resp) {
@@ -93,15 +104,35 @@ CallbackQuery::CallbackQuery(Client& client, QueryCommand& cmd, Status &status,
 
     status = lcb_n1p_mkcmd(cmd.m_params, &c_cmd);
     if (status) {
-        status = lcb_n1ql_query(m_cli.handle(), this, &c_cmd);
+        issue(c_cmd, status);
     }
 }
 
+CallbackQuery::CallbackQuery(Client& client, const PreparedCommand& cmd, Status &status,
+    RowCallback rowcb, DoneCallback donecb)
+: m_cli(client), m_rowcb(rowcb), m_donecb(donecb) {
+
+    lcb_CMDN1QL c_cmd = { 0 };
+    c_cmd.callback = Internal::n1qlcb;
+    c_cmd.query = cmd.body().c_str();
+    c_cmd.nquery = cmd.body().size();
+    issue(c_cmd, status);
+}
+
+void
+CallbackQuery::issue(lcb_CMDN1QL& cmd, Status& status) {
+    m_start = Internal::now_ns();
+    status = lcb_n1ql_query(m_cli.handle(), this, &cmd);
+}
+
 void
 CallbackQuery::_dispatch(const lcb_RESPN1QL *resp) {
     if (resp->rflags & LCB_RESP_F_FINAL) {
         // Handle last response..
         m_done = true;
+        if (Internal::Metrics *metrics = m_cli._metrics()) {
+            metrics->record(OpType::N1QL, m_start);
+        }
         m_donecb(QueryMeta(resp), this);
     } else {
         m_rowcb(QueryRow(resp), this);
@@ -110,18 +141,90 @@ CallbackQuery::_dispatch(const lcb_RESPN1QL *resp) {
 
 Query::Query(Client& cli, QueryCommand& cmd, Status& st)
 : CallbackQuery(cli, cmd, st,
-    [this](QueryRow&& row, CallbackQuery*){
-        row.detatch();
-        rp_add(std::move(row));
-        this->m_cli.breakout();
-    },
-    [this](QueryMeta&& meta, CallbackQuery*){
-        m_meta = std::move(meta);
-        this->m_cli.breakout();
-    })
+    [this](QueryRow&& row, CallbackQuery*){ handle_row(std::move(row)); },
+    [this](QueryMeta&& meta, CallbackQuery*){ handle_done(std::move(meta)); })
+{
+}
+
+Query::Query(Client& cli, const PreparedCommand& cmd, Status& st)
+: CallbackQuery(cli, cmd, st,
+    [this](QueryRow&& row, CallbackQuery*){ handle_row(std::move(row)); },
+    [this](QueryMeta&& meta, CallbackQuery*){ handle_done(std::move(meta)); })
 {
 }
 
+void
+Query::handle_row(QueryRow&& row) {
+    row.detatch(rp_slab, m_cli.memory_resource());
+    bool full = rp_add(std::move(row));
+    m_cli.breakout(full);
+}
+
+void
+Query::handle_done(QueryMeta&& meta) {
+    m_meta = std::move(meta);
+    m_cli.breakout();
+}
+
+PreparedQuery::PreparedQuery(Client& client, const std::string& statement, Status& status) {
+    QueryCommand cmd("PREPARE " + statement);
+    Query q(client, cmd, status);
+    if (!status) {
+        return;
+    }
+
+    // The response contains a row describing the prepared statement. The
+    // name and plan are already JSON-encoded, so they are copied into the
+    // request as they are. Only the first such row is used; the rest of the
+    // response is still read so the query's status is known.
+    Buffer name, plan;
+    for (auto& row : q) {
+        if (!m_prefix.empty()) {
+            continue;
+        }
+        JsonView v = row.view();
+        name = v["name"].raw();
+        plan = v["encoded_plan"].raw();
+        if (!name.empty() && !plan.empty()) {
+            m_prefix.reserve(name.size() + plan.size() + 64);
+            m_prefix.assign("{\"prepared\":").append(name.data(), name.size());
+            m_prefix.append(",\"encoded_plan\":").append(plan.data(), plan.size());
+        }
+    }
+    status = q.status();
+    if (status && m_prefix.empty()) {
+        status = LCB_PROTOCOL_ERROR;
+    }
+}
+
+void
+PreparedQuery::bind(PreparedCommand& cmd, const std::vector<std::string>& args) const {
+    begin_args(cmd);
+    for (auto& arg : args) {
+        add_arg(cmd, arg.c_str(), arg.size());
+    }
+    end_args(cmd);
+}
+
+void
+PreparedQuery::begin_args(PreparedCommand& cmd) const {
+    cmd.m_body.assign(m_prefix);
+    cmd.m_body.append(",\"args\":[");
+}
+
+void
+PreparedQuery::add_arg(PreparedCommand& cmd, const char *s, size_t n) const {
+    if (cmd.m_body.back() != '[') {
+        cmd.m_body += ',';
+    }
+    cmd.m_body.append(s, n);
+}
+
+void
+PreparedQuery::end_args(PreparedCommand& cmd) const {
+    cmd.m_body.append("]}");
+}
+
 QueryMeta
 Query::execute(Client& client, const std::string& s) {
     QueryCommand cmd(s);
@@ -140,4 +243,99 @@ Query::execute(Client& client, const std::string& s) {
     return std::move(q.m_meta);
 }
 
+QueryGroup::QueryGroup(Client& client, Compare compare)
+: m_cli(client), m_compare(std::move(compare)) {
+}
+
+Status
+QueryGroup::add(QueryCommand& cmd) {
+    return issue(cmd);
+}
+
+Status
+QueryGroup::add(const PreparedCommand& cmd) {
+    return issue(cmd);
+}
+
+template <typename C> Status
+QueryGroup::issue(C& cmd) {
+    Status st;
+    std::unique_ptr<Member> m(new Member());
+    Member *mp = m.get();
+    m->query.reset(new CallbackQuery(m_cli, cmd, st,
+        [this, mp](QueryRow&& row, CallbackQuery*){ handle_row(*mp, std::move(row)); },
+        [this, mp](QueryMeta&& meta, CallbackQuery*){ handle_done(*mp, std::move(meta)); }));
+    if (st) {
+        m_members.push_back(std::move(m));
+        m_pending++;
+    }
+    return st;
+}
+
+void
+QueryGroup::handle_row(Member& m, QueryRow&& row) {
+    row.detatch(rp_slab, m_cli.memory_resource());
+    if (m_compare) {
+        m_heldrows++;
+        m_heldbytes += rp_size(row);
+        m.rows.push_back(std::move(row));
+        merge();
+        // A slow query makes the others' rows pile up in their queues
+        m_full = rp_full(m_heldrows, m_heldbytes) || m_full;
+    } else {
+        m_full = rp_add(std::move(row)) || m_full;
+    }
+    m_cli.breakout(m_full);
+    m_full = false;
+}
+
+void
+QueryGroup::handle_done(Member& m, QueryMeta&& meta) {
+    m.meta = std::move(meta);
+    m.done = true;
+    m_pending--;
+    if (m_compare) {
+        merge();
+    }
+    m_cli.breakout(m_pending == 0 || m_full);
+    m_full = false;
+}
+
+void
+QueryGroup::merge() {
+    // A row may only be yielded once every query which is still running has
+    // a row buffered, since any of them could produce a smaller one
+    for (;;) {
+        Member *best = NULL;
+        for (auto& m : m_members) {
+            if (m->rows.empty()) {
+                if (!m->done) {
+                    return;
+                }
+                continue;
+            }
+            if (best == NULL || m_compare(m->rows.front(), best->rows.front())) {
+                best = m.get();
+            }
+        }
+        if (best == NULL) {
+            return;
+        }
+        m_heldrows--;
+        m_heldbytes -= rp_size(best->rows.front());
+        m_full = rp_add(std::move(best->rows.front())) || m_full;
+        best->rows.pop_front();
+    }
+}
+
+Status
+QueryGroup::status() const {
+    for (auto& m : m_members) {
+        if (m->done && !m->meta.status()) {
+            return m->meta.status();
+        }
+    }
+    return Status();
+}
+
 }
@@ -0,0 +1,166 @@
+namespace Couchbase {
+namespace Internal {
+
+// Operations which yield a single response and may be resent if the server
+// rejected them. (Touches are sent as stores; see TouchCommand)
+template <typename T> struct Retryable { static const bool value = false; };
+template <> struct Retryable<OpInfo::Get> { static const bool value = true; };
+template <> struct Retryable<OpInfo::Store> { static const bool value = true; };
+template <> struct Retryable<OpInfo::Remove> { static const bool value = true; };
+template <> struct Retryable<OpInfo::Counter> { static const bool value = true; };
+template <> struct Retryable<OpInfo::Unlock> { static const bool value = true; };
+
+// Errors with which the server refused the operation, so it was not applied
+inline bool retry_rejected(lcb_error_t rc) {
+    return rc == LCB_ETMPFAIL || rc == LCB_EBUSY || rc == LCB_ENOMEM;
+}
+
+// Other temporary errors (timeouts, network failures) leave it unknown
+// whether the operation was applied. Only operations which have the same
+// effect when applied twice are resent after them: reads (other than
+// get-and-lock), and stores which overwrite the item unconditionally
+template <typename C> inline bool retry_idempotent(const C *) { return false; }
+inline bool retry_idempotent(const lcb_CMDGET *cmd) { return !cmd->lock; }
+inline bool retry_idempotent(const lcb_CMDSTORE *cmd) {
+    // An operation of 0 is an upsert, as is LCB_SET
+    return (cmd->operation == 0 || cmd->operation == LCB_SET) && cmd->cas == 0;
+}
+
+// The value buffer must be owned by the operation so that it can be resent
+template <typename C> inline bool retry_ownable(const C *) { return true; }
+inline bool retry_ownable(const lcb_CMDSTORE *cmd) {
+    return cmd->value.vtype == LCB_KV_COPY || cmd->value.vtype == LCB_KV_CONTIG;
+}
+template <typename C> inline void retry_own(C *, std::string&) {}
+inline void retry_own(lcb_CMDSTORE *cmd, std::string& buf) {
+    buf.assign(static_cast<const char*>(cmd->value.u_buf.contig.bytes),
+        cmd->value.u_buf.contig.nbytes);
+    cmd->value.u_buf.contig.bytes = buf.data();
+}
+
+class RetryBase : public Handler {
+public:
+    virtual void retry(lcb_timer_t timer) = 0;
+};
+
+extern "C" {
+static void retrytimer(lcb_timer_t timer, lcb_t, const void *cookie) {
+    const_cast<RetryBase*>(reinterpret_cast<const RetryBase*>(cookie))->retry(timer);
+}
+}
+
+//! @private
+//! Handler interposed between the library and an operation's own handler
+//! when a RetryPolicy is in effect. It keeps a copy of the command so the
+//! operation can be rescheduled from a timer, and only forwards the final
+//! response.
+template <typename T>
+class RetryOp : public RetryBase {
+public:
+    typedef typename T::CType CType;
+    typedef typename T::RType RType;
+    typedef lcb_error_t (*Scheduler)(lcb_t, const void*, const CType*);
+
+    static bool applies(const CType *cmd) {
+        return Retryable<T>::value && retry_ownable(cmd);
+    }
+
+    RetryOp(Client& client, const CType *cmd, Scheduler sched, Handler *target)
+    : m_client(client), m_cmd(*cmd), m_sched(sched), m_target(target) {
+        m_key.assign(static_cast<const char*>(cmd->key.contig.bytes), cmd->key.contig.nbytes);
+        m_cmd.key.contig.bytes = m_key.data();
+        retry_own(&m_cmd, m_value);
+        m_idempotent = retry_idempotent(&m_cmd);
+        m_deadline = std::chrono::steady_clock::now() +
+                std::chrono::microseconds(client.retry_policy().deadline());
+    }
+
+    Status schedule() {
+        return m_sched(m_client.handle(), static_cast<Handler*>(this), &m_cmd);
+    }
+
+    void handle_response(Client& client, int cbtype, const lcb_RESPBASE *rb) override {
+        if (m_delivered) {
+            // A later response the handler asked for itself (e.g. the
+            // durability check of a DurableResponse)
+            m_target->handle_response(client, cbtype, rb);
+            return;
+        }
+        Status st(rb->rc);
+        const RetryPolicy& policy = client.retry_policy();
+        m_waiting = false;
+
+        bool again = retry_rejected(st) || (m_idempotent && st.isTemporary());
+        if (again && !m_final) {
+            uint32_t delay = policy.delay(m_attempts, client.m_rng());
+            if (m_attempts < policy.max_attempts() &&
+                    std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(delay) < m_deadline) {
+                lcb_error_t err = LCB_SUCCESS;
+                lcb_timer_create(client.handle(), static_cast<RetryBase*>(this), delay, 0, retrytimer, &err);
+                if (err == LCB_SUCCESS) {
+                    memset(&m_last, 0, sizeof m_last);
+                    memcpy(&m_last, rb, sizeof(lcb_RESPBASE));
+                    m_cbtype = cbtype;
+                    m_attempts++;
+                    m_waiting = true;
+                    client.m_retrystats.retries++;
+                    return;
+                }
+            }
+            client.m_retrystats.exhausted++;
+        } else if (st && m_attempts > 1) {
+            client.m_retrystats.recovered++;
+        }
+        m_delivered = true;
+        m_target->handle_response(client, cbtype, rb);
+    }
+
+    bool done() const override {
+        return !m_waiting && m_target->done();
+    }
+
+    void finish() override {
+        m_target->finish();
+        delete this;
+    }
+
+    void retry(lcb_timer_t timer) override {
+        lcb_timer_destroy(m_client.handle(), timer);
+        m_client.enter();
+        Status st = schedule();
+        if (st) {
+            m_client.leave();
+            return;
+        }
+        m_client.fail();
+
+        // Deliver the scheduling failure through the normal dispatch path so
+        // the client's bookkeeping for the operation is completed
+        m_final = true;
+        m_last.cookie = static_cast<Handler*>(this);
+        m_last.key = m_key.data();
+        m_last.nkey = m_key.size();
+        m_last.rc = st;
+        m_client._dispatch(m_cbtype, reinterpret_cast<const lcb_RESPBASE*>(&m_last));
+    }
+
+private:
+    Client& m_client;
+    CType m_cmd;
+    Scheduler m_sched;
+    Handler *m_target;
+    std::string m_key;
+    std::string m_value;
+    std::chrono::steady_clock::time_point m_deadline;
+    RType m_last;
+    int m_cbtype = 0;
+    unsigned m_attempts = 1;
+    bool m_waiting = false;
+    bool m_final = false;
+    bool m_delivered = false;
+    bool m_idempotent = false;
+};
+
+} // namespace Internal
+} // namespace Couchbase
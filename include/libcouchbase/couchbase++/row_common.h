@@ -3,12 +3,102 @@
 
 #include <cstdlib>
 #include <cstddef>
+#include <new>
 
 namespace Couchbase {
 namespace Internal {
 
 template <typename TRow> class RowIterator;
 
+//! @private
+//! Packs row payloads into large shared slabs. Each allocation is an
+//! aliasing pointer into the current slab, so detaching a row costs a
+//! reference count increment rather than a heap allocation. A slab is freed
+//! once every row referring to it has been destroyed.
+class RowSlab {
+public:
+    RowSlab(size_t slabsize = 64 * 1024) : m_slabsize(slabsize) {}
+
+    std::shared_ptr<char> allocate(MemoryResource *resource, size_t n) {
+        if (n > m_slabsize / 4) {
+            // Large rows would waste most of a slab
+            return make_buffer(resource, n);
+        }
+        if (m_slab == NULL || resource != m_resource || m_used + n > m_slabsize) {
+            m_slab = make_buffer(resource, m_slabsize);
+            m_resource = resource;
+            m_used = 0;
+        }
+        std::shared_ptr<char> ret(m_slab, m_slab.get() + m_used);
+        m_used += n;
+        return ret;
+    }
+
+private:
+    RowSlab(const RowSlab&) = delete;
+    RowSlab& operator=(const RowSlab&) = delete;
+    std::shared_ptr<char> m_slab;
+    MemoryResource *m_resource = NULL;
+    size_t m_slabsize;
+    size_t m_used = 0;
+};
+
+//! @private
+//! FIFO ring of rows. Storage grows by doubling and is reused as rows are
+//! consumed, so a steady stream of rows does not allocate.
+template <typename T>
+class RowRing {
+public:
+    RowRing() {}
+    ~RowRing() {
+        while (!empty()) {
+            pop_front();
+        }
+        ::operator delete(m_data);
+    }
+
+    bool empty() const { return m_count == 0; }
+    size_t size() const { return m_count; }
+    T& front() { return m_data[m_head]; }
+
+    void push_back(T&& row) {
+        if (m_count == m_capacity) {
+            grow();
+        }
+        new (&m_data[(m_head + m_count) & (m_capacity - 1)]) T(std::move(row));
+        m_count++;
+    }
+
+    void pop_front() {
+        m_data[m_head].~T();
+        m_head = (m_head + 1) & (m_capacity - 1);
+        m_count--;
+    }
+
+private:
+    RowRing(const RowRing&) = delete;
+    RowRing& operator=(const RowRing&) = delete;
+
+    void grow() {
+        size_t ncap = m_capacity ? m_capacity * 2 : 16;
+        T *ndata = static_cast<T*>(::operator new(ncap * sizeof(T)));
+        for (size_t ii = 0; ii < m_count; ii++) {
+            T& cur = m_data[(m_head + ii) & (m_capacity - 1)];
+            new (&ndata[ii]) T(std::move(cur));
+            cur.~T();
+        }
+        ::operator delete(m_data);
+        m_data = ndata;
+        m_capacity = ncap;
+        m_head = 0;
+    }
+
+    T *m_data = NULL;
+    size_t m_head = 0;
+    size_t m_count = 0;
+    size_t m_capacity = 0;
+};
+
 template <typename TRow>
 class RowProvider {
 public:
@@ -17,18 +107,63 @@ public:
     TIter rp_begin() { return TIter(this).mkbegin(); }
     TIter rp_end() { return TIter(this).mkend(); }
 
+    //! @brief Limit how many rows may be buffered ahead of the iterator
+    //! @details
+    //! Once either limit is reached the event loop is stopped, so no more
+    //! data is read from the network until the iterator has consumed the
+    //! buffered rows. Rows already received in the same network read are
+    //! still buffered, so the limits may be exceeded by up to one read's
+    //! worth of rows.
+    //! @param rows maximum number of buffered rows. 0 for no limit
+    //! @param bytes maximum size of buffered row data. 0 for no limit
+    void buffer_limit(size_t rows, size_t bytes = 0) {
+        m_maxrows = rows;
+        m_maxbytes = bytes;
+    }
+
+    //! Number of rows received but not yet consumed by the iterator
+    size_t rows_buffered() const { return rows.size(); }
+    //! Size of the row data received but not yet consumed by the iterator
+    size_t bytes_buffered() const { return m_bytes; }
+
 protected:
     virtual bool rp_active() const = 0;
     virtual void rp_wait() = 0;
+    //! Size of a row's data, for accounting against the byte limit
+    virtual size_t rp_size(const TRow& row) const = 0;
+
+    //! Storage for the payloads of detached rows
+    RowSlab rp_slab;
 
-    void rp_add(TRow&& row) {
-        rows.push_back(row);
+    //! Whether the buffered rows, together with `nrows` rows of `nbytes`
+    //! bytes held elsewhere by the provider, reach either limit
+    bool rp_full(size_t nrows, size_t nbytes) const {
+        return (m_maxrows && rows.size() + nrows >= m_maxrows) ||
+                (m_maxbytes && m_bytes + nbytes >= m_maxbytes);
+    }
+
+    //! Buffer a row
+    //! @return true if the buffer is full, and the caller should stop the
+    //! event loop
+    bool rp_add(TRow&& row) {
+        m_bytes += rp_size(row);
+        rows.push_back(std::move(row));
+        return (m_maxrows && rows.size() >= m_maxrows) ||
+                (m_maxbytes && m_bytes >= m_maxbytes);
     }
 
 private:
-    std::deque<TRow> rows;
+    RowRing<TRow> rows;
+    size_t m_bytes = 0;
+    size_t m_maxrows = 0;
+    size_t m_maxbytes = 0;
     friend RowIterator<TRow>;
 
+    void rp_pop() {
+        m_bytes -= rp_size(rows.front());
+        rows.pop_front();
+    }
+
     const TRow* rp_next() {
         GT_RETRY:
         if (!rows.empty()) {
@@ -63,7 +198,7 @@ public:
     }
 
     RowIterator& operator++() {
-        rp->rows.pop_front();
+        rp->rp_pop();
         pp = rp->rp_next();
         return *this;
     }
@@ -0,0 +1,278 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_ROWMAP_H
+#define LCB_PLUSPLUS_ROWMAP_H
+
+#include <libcouchbase/couchbase++/query.h>
+#include <tuple>
+#include <type_traits>
+
+namespace Couchbase {
+
+//! @brief Maps a JSON object member to a struct member
+//! @see LCB_CXX_ROW_FIELDS
+template <typename T, typename M>
+struct RowField {
+    const char *name;
+    size_t nname;
+    M T::*member;
+};
+
+template <typename T, typename M, size_t N> RowField<T, M>
+make_row_field(const char (&name)[N], M T::*member) {
+    RowField<T, M> ret = { name, N - 1, member };
+    return ret;
+}
+
+//! Map the struct member `member` to the JSON field of the same name
+#define LCB_CXX_FIELD(T, member) ::Couchbase::make_row_field(#member, &T::member)
+//! Map the struct member `member` to the JSON field `name`
+#define LCB_CXX_NAMED_FIELD(T, member, name) ::Couchbase::make_row_field(name, &T::member)
+
+//! @brief Declare how a struct is decoded from a JSON object
+//! @details
+//! This must be used at namespace scope, in the namespace of the struct:
+//!
+//! @code{c++}
+//! struct Airline {
+//!     std::string name;
+//!     int64_t id;
+//!     std::string country;
+//! };
+//! LCB_CXX_ROW_FIELDS(Airline,
+//!     LCB_CXX_FIELD(Airline, name),
+//!     LCB_CXX_FIELD(Airline, id),
+//!     LCB_CXX_FIELD(Airline, country))
+//!
+//! RowDecoder<Airline> decoder;
+//! Airline a;
+//! for (auto& row : query) {
+//!     decoder.decode(row, a);
+//! }
+//! @endcode
+//!
+//! Supported member types are integers, floating point numbers, `bool`,
+//! `std::string`, Buffer and JsonView (which refer to the row's memory and
+//! are only valid for as long as it), `std::vector`s of supported types, and
+//! other structs declared with this macro.
+#define LCB_CXX_ROW_FIELDS(T, ...) \
+    inline auto lcb_row_fields(const T*) -> decltype(std::make_tuple(__VA_ARGS__)) { \
+        return std::make_tuple(__VA_ARGS__); \
+    }
+
+template <typename T> class RowDecoder;
+
+namespace Internal {
+
+template <typename T>
+struct RowFieldsOf {
+    typedef decltype(lcb_row_fields(static_cast<const T*>(NULL))) type;
+};
+
+template <typename T>
+class HasRowFields {
+    template <typename U> static char test(decltype(lcb_row_fields(static_cast<const U*>(NULL)))*);
+    template <typename U> static long test(...);
+public:
+    static const bool value = sizeof(test<T>(NULL)) == 1;
+};
+
+inline void decode_value(const JsonView& v, bool& out) { out = v.as_bool(out); }
+inline void decode_value(const JsonView& v, std::string& out) {
+    if (v.has_escapes()) {
+        out = v.as_string();
+    } else {
+        Buffer b = v.as_buffer();
+        out.assign(b.data(), b.size());
+    }
+}
+// These two refer to the decoded row's memory rather than copying it, and
+// are only valid for as long as the row is
+inline void decode_value(const JsonView& v, Buffer& out) { out = v.as_buffer(); }
+inline void decode_value(const JsonView& v, JsonView& out) { out = v; }
+
+template <typename N> inline typename std::enable_if<
+    std::is_integral<N>::value && !std::is_same<N, bool>::value>::type
+decode_value(const JsonView& v, N& out) {
+    out = static_cast<N>(v.as_int(static_cast<int64_t>(out)));
+}
+
+template <typename N> inline typename std::enable_if<
+    std::is_floating_point<N>::value>::type
+decode_value(const JsonView& v, N& out) {
+    out = static_cast<N>(v.as_double(out));
+}
+
+template <typename U> inline typename std::enable_if<HasRowFields<U>::value>::type
+decode_value(const JsonView& v, U& out);
+
+template <typename U> inline void
+decode_value(const JsonView& v, std::vector<U>& out) {
+    out.clear();
+    for (auto& elem : v) {
+        out.push_back(U());
+        decode_value(elem.value, out.back());
+    }
+}
+
+// Whether a decoded type refers to the row's memory
+template <typename T, typename Enable = void> struct Borrows : std::false_type {};
+template <> struct Borrows<Buffer> : std::true_type {};
+template <> struct Borrows<JsonView> : std::true_type {};
+template <typename U> struct Borrows<std::vector<U>> : Borrows<U> {};
+
+template <typename Tuple> struct FieldsBorrow;
+template <> struct FieldsBorrow<std::tuple<>> : std::false_type {};
+template <typename T, typename M, typename ...F>
+struct FieldsBorrow<std::tuple<RowField<T, M>, F...>>
+: std::integral_constant<bool, Borrows<M>::value || FieldsBorrow<std::tuple<F...>>::value> {};
+
+template <typename T>
+struct Borrows<T, typename std::enable_if<HasRowFields<T>::value>::type>
+: FieldsBorrow<typename RowFieldsOf<T>::type> {};
+
+// Decode into the field at a runtime index. The chain of comparisons is
+// generated at compile time, one per field.
+template <size_t I = 0, typename T, typename ...F>
+inline typename std::enable_if<I == sizeof...(F)>::type
+decode_field(const std::tuple<F...>&, size_t, const JsonView&, T&) {}
+
+template <size_t I = 0, typename T, typename ...F>
+inline typename std::enable_if<I < sizeof...(F)>::type
+decode_field(const std::tuple<F...>& fields, size_t ix, const JsonView& v, T& obj) {
+    if (ix == I) {
+        decode_value(v, obj.*(std::get<I>(fields).member));
+    } else {
+        decode_field<I + 1>(fields, ix, v, obj);
+    }
+}
+
+template <size_t I = 0, typename ...F>
+inline typename std::enable_if<I == sizeof...(F)>::type
+field_names(const std::tuple<F...>&, Buffer *) {}
+
+template <size_t I = 0, typename ...F>
+inline typename std::enable_if<I < sizeof...(F)>::type
+field_names(const std::tuple<F...>& fields, Buffer *out) {
+    out[I] = Buffer(std::get<I>(fields).name, std::get<I>(fields).nname);
+    field_names<I + 1>(fields, out);
+}
+
+} // namespace Internal
+
+//! @brief Decodes JSON objects into a struct declared with
+//! LCB_CXX_ROW_FIELDS.
+//! @details
+//! Decoding is a single pass over the object's members, without building
+//! any intermediate representation. Members not in the field map are
+//! skipped, and fields missing from the object are left untouched.
+//!
+//! Rows of a query result almost always list their members in the same
+//! order, so the decoder remembers the order in which it last saw the
+//! fields and checks the expected field first. In the common case, each
+//! member then costs a single name comparison.
+template <typename T>
+class RowDecoder {
+public:
+    typedef typename Internal::RowFieldsOf<T>::type Fields;
+    static const size_t NFIELDS = std::tuple_size<Fields>::value;
+
+    RowDecoder() : m_fields(lcb_row_fields(static_cast<const T*>(NULL))) {
+        Internal::field_names(m_fields, m_names);
+        for (size_t ii = 0; ii < NFIELDS; ii++) {
+            m_next[ii] = (ii + 1) % NFIELDS;
+        }
+    }
+
+    //! @brief Decode an object
+    //! @return false if the value is not a JSON object
+    bool decode(const JsonView& v, T& out) {
+        if (v.type() != JsonView::OBJECT) {
+            return false;
+        }
+        size_t expect = 0, prev = NFIELDS;
+        for (auto& member : v) {
+            size_t ix = find(member.name, expect);
+            if (ix == NFIELDS) {
+                continue;
+            }
+            Internal::decode_field(m_fields, ix, member.value, out);
+            if (prev != NFIELDS) {
+                m_next[prev] = ix;
+            }
+            prev = ix;
+            expect = m_next[ix];
+        }
+        return true;
+    }
+
+    //! Decode a query row
+    bool decode(const QueryRow& row, T& out) {
+        return decode(row.view(), out);
+    }
+
+    //! Decode a query row into a new object
+    T decode(const QueryRow& row) {
+        T ret = T();
+        decode(row, ret);
+        return ret;
+    }
+
+private:
+    size_t find(const Buffer& name, size_t expect) const {
+        if (matches(name, expect)) {
+            return expect;
+        }
+        for (size_t ii = 0; ii < NFIELDS; ii++) {
+            if (matches(name, ii)) {
+                return ii;
+            }
+        }
+        return NFIELDS;
+    }
+
+    bool matches(const Buffer& name, size_t ix) const {
+        const Buffer& f = m_names[ix];
+        return f.size() == name.size() && memcmp(f.data(), name.data(), f.size()) == 0;
+    }
+
+    Fields m_fields;
+    Buffer m_names[NFIELDS];
+    // The field which followed each field in the last decoded object
+    size_t m_next[NFIELDS];
+};
+
+namespace Internal {
+template <typename U> inline typename std::enable_if<HasRowFields<U>::value>::type
+decode_value(const JsonView& v, U& out) {
+    RowDecoder<U> decoder;
+    decoder.decode(v, out);
+}
+}
+
+//! @brief Decode every row of a query
+//! @details
+//! Each row is released as soon as it has been decoded, so `T` may not
+//! contain Buffer or JsonView members (at any depth), which would be left
+//! referring to freed memory. Use RowDecoder directly to decode such types
+//! while iterating.
+//! @param query the query to iterate
+//! @param[out] out the decoded rows are appended here
+//! @return the status of the query
+template <typename T> inline Status
+decode_rows(Query& query, std::vector<T>& out) {
+    static_assert(!Internal::Borrows<T>::value,
+        "decode_rows() cannot decode Buffer or JsonView members: rows do not outlive the loop");
+    RowDecoder<T> decoder;
+    for (auto& row : query) {
+        out.push_back(T());
+        decoder.decode(row, out.back());
+    }
+    return query.status();
+}
+
+} // namespace Couchbase
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef LCB_PLUSPLUS_H
+#error "Include <libcouchbase/couchbase++.h> first!"
+#endif
+
+#ifndef LCB_PLUSPLUS_ROWSTREAM_H
+#define LCB_PLUSPLUS_ROWSTREAM_H
+
+#include <libcouchbase/couchbase++/query.h>
+#include <libcouchbase/couchbase++/views.h>
+
+#ifdef LCB_CXX_HAVE_COROUTINES
+#include <coroutine>
+
+namespace Couchbase {
+namespace Internal {
+
+//! @private
+//! Hands rows from a query callback to a coroutine. If the coroutine is
+//! already waiting for a row, it is resumed directly with the row received
+//! from the network (no copy is made). Otherwise the row is detached and
+//! buffered until the coroutine asks for it.
+template <typename TRow>
+class RowChannel {
+public:
+    class Next {
+    public:
+        bool await_ready() {
+            ch.advance();
+            return !ch.m_rows.empty() || ch.m_closed;
+        }
+        void await_suspend(std::coroutine_handle<> h) { ch.m_waiter = h; }
+        const TRow* await_resume() { return ch.current(); }
+    private:
+        friend class RowChannel;
+        Next(RowChannel& c) : ch(c) {}
+        RowChannel& ch;
+    };
+
+    Next next() { return Next(*this); }
+
+    void push(TRow&& row) {
+        if (m_waiter) {
+            m_direct = &row;
+            resume();
+            m_direct = NULL;
+        } else {
+            row.detatch();
+            m_rows.push_back(std::move(row));
+        }
+    }
+
+    void close() {
+        m_closed = true;
+        if (m_waiter) {
+            resume();
+        }
+    }
+
+private:
+    void resume() {
+        std::coroutine_handle<> h = m_waiter;
+        m_waiter = nullptr;
+        h.resume();
+    }
+
+    // Drop the buffered row returned by the previous call to next()
+    void advance() {
+        if (m_front_taken) {
+            m_rows.pop_front();
+            m_front_taken = false;
+        }
+    }
+
+    const TRow* current() {
+        if (m_direct != NULL) {
+            return m_direct;
+        }
+        if (!m_rows.empty()) {
+            m_front_taken = true;
+            return &m_rows.front();
+        }
+        return NULL;
+    }
+
+    std::deque<TRow> m_rows;
+    const TRow *m_direct = NULL;
+    std::coroutine_handle<> m_waiter;
+    bool m_front_taken = false;
+    bool m_closed = false;
+};
+
+} // namespace Internal
+
+//! @brief N1QL query whose rows may be consumed from a coroutine
+//! @details
+//! @code{c++}
+//! AsyncQuery q(client, cmd, status);
+//! while (const QueryRow *row = co_await q.next()) {
+//!     ...
+//! }
+//! if (!q.meta().status()) { ... }
+//! @endcode
+//!
+//! The event loop must be driven (via Client::wait()) for rows to arrive.
+//! The row returned by #next() is only valid until the next `co_await`.
+//! The query must be consumed until #next() yields `NULL` before the
+//! object is destroyed.
+//!
+//! @note Only available when compiling with C++20 coroutine support
+class AsyncQuery : public CallbackQuery {
+public:
+    AsyncQuery(Client& client, QueryCommand& cmd, Status& status)
+    : CallbackQuery(client, cmd, status,
+        [this](QueryRow&& row, CallbackQuery*) {
+            m_rows.push(std::move(row));
+        },
+        [this](QueryMeta&& meta, CallbackQuery*) {
+            m_meta = std::move(meta);
+            m_rows.close();
+        }) {
+        if (!status) {
+            m_rows.close();
+        }
+    }
+
+    //! Wait for the next row
+    //! @return an awaitable yielding a pointer to the next row, or `NULL`
+    //!         once all rows have been received.
+    Internal::RowChannel<QueryRow>::Next next() { return m_rows.next(); }
+
+    //! Get the query metadata. Only valid once #next() has yielded `NULL`
+    const QueryMeta& meta() const { return m_meta; }
+
+private:
+    Internal::RowChannel<QueryRow> m_rows;
+    QueryMeta m_meta;
+};
+
+//! @brief View query whose rows may be consumed from a coroutine
+//! @see AsyncQuery
+class AsyncViewQuery : public CallbackViewQuery {
+public:
+    AsyncViewQuery(Client& client, const ViewCommand& cmd, Status& status)
+    : CallbackViewQuery(client, cmd, status,
+        [this](ViewRow&& row, CallbackViewQuery*) {
+            m_rows.push(std::move(row));
+        },
+        [this](ViewMeta&& meta, CallbackViewQuery*) {
+            m_meta = std::move(meta);
+            m_rows.close();
+        }) {
+        if (!status) {
+            m_rows.close();
+        }
+    }
+
+    //! Wait for the next row
+    //! @return an awaitable yielding a pointer to the next row, or `NULL`
+    //!         once all rows have been received.
+    Internal::RowChannel<ViewRow>::Next next() { return m_rows.next(); }
+
+    //! Get the view metadata. Only valid once #next() has yielded `NULL`
+    const ViewMeta& meta() const { return m_meta; }
+
+private:
+    Internal::RowChannel<ViewRow> m_rows;
+    ViewMeta m_meta;
+};
+
+} // namespace Couchbase
+
+#endif // LCB_CXX_HAVE_COROUTINES
+#endif
@@ -83,6 +83,11 @@ private:
 
 class ViewRow {
 public:
+    inline ViewRow(const ViewRow& other);
+    ViewRow(ViewRow&&) = default;
+    inline ViewRow& operator=(const ViewRow& other);
+    ViewRow& operator=(ViewRow&&) = default;
+
     //! Get the emitted key
     //! @return the emitted key as a string
     const Buffer& key() const { return m_key; }
@@ -107,7 +112,15 @@ public:
     //! @return A reference to a document
     const GetResponse& document() const { return m_document; }
 
-    inline void detatch();
+    //! Makes the row's buffers scoped to the row itself, so the row may be
+    //! kept after the callback returns.
+    //! @param resource where to allocate the row's copy from. If `NULL`, the
+    //!        default resource is used.
+    inline void detatch(MemoryResource *resource = NULL);
+
+    //! @private
+    //! Detach the row into a shared slab
+    inline void detatch(Internal::RowSlab& slab, MemoryResource *resource);
 
     //! Indicates whether a GetResponse is available.
     //! @return true if there is a GetResponse
@@ -116,7 +129,9 @@ public:
     bool has_document() const { return m_hasdoc; }
 private:
     inline char *detatch_buf(Buffer& tgt, char *tmp);
-    ViewRow(Client&, const lcb_RESPVIEWQUERY *resp);
+    inline size_t detatch_size() const;
+    inline void detatch_to(std::shared_ptr<char>&& buf);
+    inline ViewRow(Client&, const lcb_RESPVIEWQUERY *resp);
 
     std::shared_ptr<char> m_buf;
     Buffer m_key;
@@ -125,7 +140,7 @@ private:
     Buffer m_docid;
 
     GetResponse m_document;
-    bool m_hasdoc;
+    bool m_hasdoc = false;
     friend class Client;
     friend class CallbackViewQuery;
 };
@@ -185,6 +200,7 @@ private:
     RowCallback m_rowcb = NULL;
     DoneCallback m_donecb = NULL;
     lcb_VIEWHANDLE vh = NULL;
+    uint64_t m_start = 0;
 };
 
 //! This class may be used to execute a view query and iterate over its
@@ -208,14 +224,22 @@ public:
     inline const_iterator end() { return rp_end(); }
     inline Status status() const;
 
+    using Internal::RowProvider<ViewRow>::buffer_limit;
+    using Internal::RowProvider<ViewRow>::rows_buffered;
+    using Internal::RowProvider<ViewRow>::bytes_buffered;
+
 protected:
     bool rp_active() const override { return active(); }
     void rp_wait() override { cli.wait(); }
+    size_t rp_size(const ViewRow& row) const override {
+        return row.key().size() + row.value().size() + row.docid().size() +
+                row.geometry().size() + row.document().value().size();
+    }
 
 private:
     ViewMeta m_meta;
-    void handle_row(ViewRow&&);
-    void handle_done(ViewMeta&&);
+    inline void handle_row(ViewRow&&);
+    inline void handle_done(ViewMeta&&);
 };
 
 namespace Internal {
@@ -83,16 +83,52 @@ ViewRow::ViewRow(Client& c, const lcb_RESPVIEWQUERY *resp) {
     }
 }
 
+ViewRow::ViewRow(const ViewRow& other)
+: m_buf(other.m_buf), m_key(other.m_key), m_value(other.m_value),
+  m_geometry(other.m_geometry), m_docid(other.m_docid),
+  m_hasdoc(other.m_hasdoc) {
+    m_document.assign_shared(other.m_document);
+}
+
+ViewRow&
+ViewRow::operator=(const ViewRow& other) {
+    if (this != &other) {
+        m_buf = other.m_buf;
+        m_key = other.m_key;
+        m_value = other.m_value;
+        m_geometry = other.m_geometry;
+        m_docid = other.m_docid;
+        m_hasdoc = other.m_hasdoc;
+        m_document.clear();
+        m_document.assign_shared(other.m_document);
+    }
+    return *this;
+}
+
 void
-ViewRow::detatch() {
-    if (m_buf != NULL) {
-        return;
+ViewRow::detatch(MemoryResource *resource) {
+    if (m_buf == NULL) {
+        detatch_to(Internal::make_buffer(resource, detatch_size()));
     }
+}
 
-    size_t total_alloc = m_key.length() + m_value.length() +
+void
+ViewRow::detatch(Internal::RowSlab& slab, MemoryResource *resource) {
+    if (m_buf == NULL) {
+        detatch_to(slab.allocate(resource, detatch_size()));
+    }
+}
+
+size_t
+ViewRow::detatch_size() const {
+    return m_key.length() + m_value.length() +
             m_docid.length() + m_geometry.length();
-    char *tmp = new char[total_alloc];
-    m_buf.reset(tmp, std::default_delete<char[]>());
+}
+
+void
+ViewRow::detatch_to(std::shared_ptr<char>&& buf) {
+    m_buf = std::move(buf);
+    char *tmp = m_buf.get();
 
     tmp = detatch_buf(m_key, tmp);
     tmp = detatch_buf(m_value, tmp);
@@ -118,6 +154,7 @@ CallbackViewQuery::CallbackViewQuery(
     RowCallback rowcb, DoneCallback donecb)
 : cli(client), m_rowcb(rowcb), m_donecb(donecb) {
 
+    m_start = Internal::now_ns();
     status = lcb_view_query(client.handle(), this, &cmd);
     if (status) {
         vh = cmd.vhptr;
@@ -129,6 +166,9 @@ CallbackViewQuery::_dispatch(const lcb_RESPVIEWQUERY *resp) {
     if (!(resp->rflags & LCB_RESP_F_FINAL)) {
         m_rowcb(ViewRow(cli, resp), this);
     } else {
+        if (Internal::Metrics *metrics = cli._metrics()) {
+            metrics->record(OpType::VIEW, m_start);
+        }
         m_donecb(ViewMeta(resp), this);
         vh = NULL;
     }
@@ -160,9 +200,9 @@ CallbackViewQuery::~CallbackViewQuery() {
 
 void
 ViewQuery::handle_row(ViewRow&& row) {
-    row.detatch();
-    rp_add(std::move(row));
-    cli.breakout();
+    row.detatch(rp_slab, cli.memory_resource());
+    bool full = rp_add(std::move(row));
+    cli.breakout(full);
 }
 
 void
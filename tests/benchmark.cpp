@@ -0,0 +1,304 @@
+// Microbenchmarks for the parts of the library which run without a server.
+// ClientPool's checkout and return are measured with unconnected clients, as
+// they never touch the network. Paths whose cost is dominated by network
+// round trips (Client::get_multi(), BulkWriter) are not covered here:
+//
+// - get_multi() schedules every key in one scheduling scope, so the keys go
+//   out in a single pipeline and the call takes as long as its slowest key.
+//   Its only in-memory cost is one GetResponse per key in a vector sized up
+//   front, which is what ArenaBatchCommand's numbers below measure.
+// - BulkWriter keeps a fixed window of mutations in flight and refills it
+//   from the response callbacks, so throughput is bounded by the window
+//   divided by the round trip time while memory stays bounded by the window.
+//   Both depend only on the server's latency.
+//
+// Build with `make benchmark` and run bin/benchmark; the numbers are only
+// meaningful relative to each other, on an optimized build. The compression
+// cases are only built if Snappy is found.
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/jsonview.h>
+#include <libcouchbase/couchbase++/rowmap.h>
+#include <libcouchbase/couchbase++/columnar.h>
+#include <libcouchbase/couchbase++/pool.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Couchbase;
+
+static volatile size_t sink;
+
+// Run `fn`, which performs `ops` operations, repeatedly for a while and
+// print the mean time per operation.
+template <typename F> static void
+run(const char *name, size_t ops, F fn)
+{
+    using namespace std::chrono;
+    fn(); // Warm up
+    size_t rounds = 0;
+    steady_clock::time_point begin = steady_clock::now();
+    steady_clock::duration elapsed;
+    do {
+        fn();
+        rounds++;
+        elapsed = steady_clock::now() - begin;
+    } while (elapsed < milliseconds(250));
+    double ns = duration_cast<nanoseconds>(elapsed).count();
+    printf("%-36s %10.1f ns/op\n", name, ns / (rounds * ops));
+}
+
+static void
+bench_batch()
+{
+    const size_t count = 10000;
+    run("BatchCommand list (per response)", count, [&]() {
+        BatchCommand<GetCommand, GetResponse>::RList list;
+        for (size_t ii = 0; ii < count; ii++) {
+            list.push_back(GetResponse());
+            sink += list.back().cas();
+        }
+    });
+
+    Internal::ResponseArena<GetResponse> arena(1024);
+    run("ArenaBatchCommand (per response)", count, [&]() {
+        for (size_t ii = 0; ii < count; ii++) {
+            sink += arena.alloc().cas();
+        }
+        arena.reset();
+    });
+}
+
+// A query row with a typical number of fields, of which only a couple are
+// of interest
+static std::string
+make_row()
+{
+    std::string row = "{";
+    for (int ii = 0; ii < 20; ii++) {
+        row += "\"field" + std::to_string(ii) + "\": ";
+        row += ii % 2 ? "\"some string value\", " : "[1, 2, {\"x\": 3}], ";
+    }
+    row += "\"count\": 42, \"country\": \"Belgium\"}";
+    return row;
+}
+
+static void
+bench_jsonview()
+{
+    const std::string row = make_row();
+    run("JsonView (2 fields of 22)", 1, [&]() {
+        JsonView v(Buffer(row.data(), row.size()));
+        sink += v["count"].as_int() + v["country"].as_buffer().size();
+    });
+
+    // What a caller without a lazy view does: decode every member up front
+    run("Decode all members (2 fields of 22)", 1, [&]() {
+        std::map<std::string, std::string> fields;
+        for (auto& m : JsonView(Buffer(row.data(), row.size()))) {
+            fields[m.name] = m.value.raw();
+        }
+        sink += std::stoll(fields["count"]) + fields["country"].size();
+    });
+}
+
+struct Airline {
+    std::string name;
+    int64_t id = 0;
+    std::string iata;
+    std::string icao;
+    std::string callsign;
+    std::string country;
+};
+LCB_CXX_ROW_FIELDS(Airline,
+    LCB_CXX_FIELD(Airline, name),
+    LCB_CXX_FIELD(Airline, id),
+    LCB_CXX_FIELD(Airline, iata),
+    LCB_CXX_FIELD(Airline, icao),
+    LCB_CXX_FIELD(Airline, callsign),
+    LCB_CXX_FIELD(Airline, country))
+
+static const std::string airline_row =
+    "{\"type\": \"airline\", \"name\": \"40-Mile Air\", \"id\": 10,"
+    " \"iata\": \"Q5\", \"icao\": \"MLA\", \"callsign\": \"MILE-AIR\","
+    " \"country\": \"United States\"}";
+
+static void
+bench_rowdecoder()
+{
+    const JsonView v(Buffer(airline_row.data(), airline_row.size()));
+
+    RowDecoder<Airline> decoder;
+    Airline a;
+    run("RowDecoder (6 fields)", 1, [&]() {
+        decoder.decode(v, a);
+        sink += a.id + a.country.size();
+    });
+
+    // Looking up each field by name rescans the row from the start
+    run("JsonView lookup per field (6 fields)", 1, [&]() {
+        a.name = v["name"].as_string();
+        a.id = v["id"].as_int();
+        a.iata = v["iata"].as_string();
+        a.icao = v["icao"].as_string();
+        a.callsign = v["callsign"].as_string();
+        a.country = v["country"].as_string();
+        sink += a.id + a.country.size();
+    });
+}
+
+static void
+bench_columnar()
+{
+    const size_t count = 4096;
+    const JsonView v(Buffer(airline_row.data(), airline_row.size()));
+
+    ColumnSchema schema;
+    schema.add("name", ColumnSchema::STRING)
+        .add("id", ColumnSchema::INT)
+        .add("iata", ColumnSchema::STRING)
+        .add("icao", ColumnSchema::STRING)
+        .add("callsign", ColumnSchema::STRING)
+        .add("country", ColumnSchema::STRING);
+    Internal::ColumnDecoder columns(schema);
+    ColumnBatch batch;
+    run("ColumnBatch (per row, 6 columns)", count, [&]() {
+        columns.reset(batch, count);
+        for (size_t ii = 0; ii < count; ii++) {
+            columns.decode(v, batch);
+        }
+        sink += batch.ints(1)[count - 1];
+    });
+
+    RowDecoder<Airline> decoder;
+    run("RowDecoder into vector (per row)", count, [&]() {
+        std::vector<Airline> rows;
+        rows.reserve(count);
+        for (size_t ii = 0; ii < count; ii++) {
+            rows.push_back(Airline());
+            decoder.decode(v, rows.back());
+        }
+        sink += rows.back().id;
+    });
+
+    // Aggregating a single column of the decoded rows
+    std::vector<Airline> rows(count);
+    for (auto& row : rows) {
+        decoder.decode(v, row);
+    }
+    run("Sum ColumnBatch column (per row)", count, [&]() {
+        const int64_t *ids = batch.ints(1);
+        const uint8_t *valid = batch.valid(1);
+        int64_t total = 0;
+        for (size_t ii = 0; ii < count; ii++) {
+            total += ids[ii] * valid[ii];
+        }
+        sink += total;
+    });
+    run("Sum struct member (per row)", count, [&]() {
+        int64_t total = 0;
+        for (auto& row : rows) {
+            total += row.id;
+        }
+        sink += total;
+    });
+}
+
+// Threads repeatedly checking a client out and returning it. With more
+// threads than clients, checkouts start to block
+static void
+bench_pool()
+{
+    const size_t count = 100000;
+    ClientPool pool(8);
+    for (size_t nthreads = 1; nthreads <= 16; nthreads *= 2) {
+        char name[64];
+        snprintf(name, sizeof name, "Lease churn, %2zu threads (per lease)", nthreads);
+        run(name, count, [&]() {
+            std::vector<std::thread> threads;
+            for (size_t ii = 0; ii < nthreads; ii++) {
+                threads.emplace_back([&]() {
+                    for (size_t jj = 0; jj < count / nthreads; jj++) {
+                        ClientPool::Lease lease = pool.acquire();
+                        sink += lease.valid();
+                    }
+                });
+            }
+            for (auto& thr : threads) {
+                thr.join();
+            }
+        });
+    }
+}
+
+#ifdef LCB_CXX_SNAPPY
+// A document of the repetitive kind which compresses well
+static std::string
+make_document()
+{
+    std::string doc = "{\"type\": \"route\", \"schedule\": [";
+    for (int ii = 0; ii < 60; ii++) {
+        doc += ii ? ", " : "";
+        doc += "{\"day\": " + std::to_string(ii % 7) + ", \"utc\": \"" +
+            std::to_string(10 + ii % 12) + ":" + std::to_string(10 + ii % 50) +
+            ":00\", \"flight\": \"AF" + std::to_string(100 + ii) + "\"}";
+    }
+    doc += "], \"equipment\": \"320\", \"sourceairport\": \"TLV\"}";
+    return doc;
+}
+
+static void
+bench_compression()
+{
+    const size_t count = 1000;
+    const std::string doc = make_document();
+    size_t nout = snappy_max_compressed_length(doc.size());
+    std::string wire(nout, '\0');
+    snappy_compress(doc.data(), doc.size(), &wire[0], &nout);
+    wire.resize(nout);
+    printf("%-36s %10zu -> %zu bytes\n", "Snappy (document on the wire)", doc.size(), wire.size());
+
+    static Client client;
+    SnappyDecompressor decomp;
+    client.decompressor(&decomp);
+    lcb_RESPGET raw;
+    memset(&raw, 0, sizeof raw);
+    raw.value = wire.data();
+    raw.nvalue = wire.size();
+    raw.datatype = LCB_VALUE_F_SNAPPYCOMP;
+
+    // What Compression::IN amounts to: every value is inflated on receipt
+    std::vector<GetResponse> resps(count);
+    run("Eager decompression (per get)", count, [&]() {
+        for (auto& resp : resps) {
+            resp.handle_response(client, LCB_CALLBACK_GET, reinterpret_cast<lcb_RESPBASE*>(&raw));
+            sink += resp.valuesize();
+        }
+    });
+    run("Lazy, 1 in 10 values read (per get)", count, [&]() {
+        size_t ix = 0;
+        for (auto& resp : resps) {
+            resp.handle_response(client, LCB_CALLBACK_GET, reinterpret_cast<lcb_RESPBASE*>(&raw));
+            if (ix++ % 10 == 0) {
+                sink += resp.valuesize();
+            }
+        }
+    });
+}
+#endif
+
+int main(int, char**)
+{
+    bench_batch();
+    bench_jsonview();
+    bench_rowdecoder();
+    bench_columnar();
+    bench_pool();
+#ifdef LCB_CXX_SNAPPY
+    bench_compression();
+#endif
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef LCB_PLUSPLUS_TESTS_CHECK_H
+#define LCB_PLUSPLUS_TESTS_CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal assertion macro for the unit tests. Unlike assert() it is not
+// compiled out in release builds.
+#define CHECK(expr) do { \
+    if (!(expr)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+        abort(); \
+    } \
+} while (0)
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef LCB_PLUSPLUS_TESTS_COUNTING_RESOURCE_H
+#define LCB_PLUSPLUS_TESTS_COUNTING_RESOURCE_H
+
+#include <libcouchbase/couchbase++/memory.h>
+
+// Memory resource which counts what is outstanding
+class CountingResource : public Couchbase::MemoryResource {
+public:
+    size_t allocs = 0;
+    size_t live = 0;
+    size_t live_bytes = 0;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        allocs++;
+        live++;
+        live_bytes += bytes;
+        return Couchbase::default_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        live--;
+        live_bytes -= bytes;
+        Couchbase::default_resource()->deallocate(p, bytes, alignment);
+    }
+};
+
+#endif
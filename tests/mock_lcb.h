@@ -0,0 +1,209 @@
+#ifndef LCB_PLUSPLUS_TESTS_MOCK_LCB_H
+#define LCB_PLUSPLUS_TESTS_MOCK_LCB_H
+
+// Stands in for the library, for tests which run operations through a
+// Client. Include it in exactly one file of a test: it defines the library
+// functions the client calls, which take precedence over the library's.
+//
+// Only gets (active and replica) are served, from a table of values. Each
+// instance queues its requests and answers them in lcb_wait3(), in order.
+// Requests for a "slow" key are held back: they are answered only when
+// nothing else can be, after the instance's timers have fired. As with the
+// library, lcb_wait3() returns once lcb_breakout() is called or nothing is
+// left pending.
+
+#include <libcouchbase/couchbase.h>
+#include <libcouchbase/api3.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+namespace Mock {
+
+// Shared by every instance; set these up before starting any I/O thread
+struct Server {
+    std::map<std::string, std::string> values;
+    std::set<std::string> slow;
+    std::map<std::string, size_t> gets;
+    std::map<std::string, size_t> replica_gets;
+};
+
+inline Server& server() { static Server s; return s; }
+
+struct Request {
+    int cbtype;
+    const void *cookie;
+    std::string key;
+    bool held;
+};
+
+struct Timer {
+    const void *cookie;
+    bool periodic;
+    lcb_timer_callback callback;
+};
+
+struct Instance {
+    const void *cookie = NULL;
+    lcb_RESPCALLBACK callback = NULL;
+    std::deque<Request> pending;
+    std::set<Timer*> timers;
+    bool broke = false;
+    // Number of held requests answered so far
+    size_t released = 0;
+};
+
+inline Instance& instance(lcb_t instance) { return *reinterpret_cast<Instance*>(instance); }
+
+inline lcb_error_t
+queue(lcb_t lcb, int cbtype, const void *cookie, const lcb_KEYBUF& kb)
+{
+    std::string key(static_cast<const char*>(kb.contig.bytes), kb.contig.nbytes);
+    bool held = cbtype == LCB_CALLBACK_GET && server().slow.count(key);
+    Request req = { cbtype, cookie, key, held };
+    instance(lcb).pending.push_back(req);
+    (cbtype == LCB_CALLBACK_GET ? server().gets : server().replica_gets)[key]++;
+    return LCB_SUCCESS;
+}
+
+inline void
+respond(lcb_t lcb, const Request& req)
+{
+    lcb_RESPGET resp;
+    memset(&resp, 0, sizeof resp);
+    resp.cookie = const_cast<void*>(req.cookie);
+    resp.key = req.key.data();
+    resp.nkey = req.key.size();
+    resp.rflags = LCB_RESP_F_FINAL;
+    auto ii = server().values.find(req.key);
+    if (ii == server().values.end()) {
+        resp.rc = LCB_KEY_ENOENT;
+    } else {
+        resp.rc = LCB_SUCCESS;
+        resp.value = ii->second.data();
+        resp.nvalue = ii->second.size();
+    }
+    instance(lcb).callback(lcb, req.cbtype, reinterpret_cast<const lcb_RESPBASE*>(&resp));
+}
+
+// Fire every timer once. Returns false if there were none
+inline bool
+fire_timers(lcb_t lcb)
+{
+    std::set<Timer*> timers = instance(lcb).timers;
+    for (Timer *timer : timers) {
+        if (!instance(lcb).timers.count(timer)) {
+            continue; // Destroyed by an earlier callback
+        }
+        if (!timer->periodic) {
+            instance(lcb).timers.erase(timer);
+        }
+        timer->callback(reinterpret_cast<lcb_timer_t>(timer), lcb, timer->cookie);
+        if (!timer->periodic) {
+            delete timer;
+        }
+    }
+    return !timers.empty();
+}
+
+} // namespace Mock
+
+extern "C" {
+
+lcb_error_t lcb_create(lcb_t *instance, const struct lcb_create_st *)
+{
+    *instance = reinterpret_cast<lcb_t>(new Mock::Instance());
+    return LCB_SUCCESS;
+}
+
+void lcb_destroy(lcb_t instance)
+{
+    for (Mock::Timer *timer : Mock::instance(instance).timers) {
+        delete timer;
+    }
+    delete &Mock::instance(instance);
+}
+
+lcb_error_t lcb_connect(lcb_t) { return LCB_SUCCESS; }
+lcb_error_t lcb_get_bootstrap_status(lcb_t) { return LCB_SUCCESS; }
+void lcb_set_cookie(lcb_t instance, const void *cookie) { Mock::instance(instance).cookie = cookie; }
+const void *lcb_get_cookie(lcb_t instance) { return Mock::instance(instance).cookie; }
+
+lcb_RESPCALLBACK lcb_install_callback3(lcb_t instance, int, lcb_RESPCALLBACK callback)
+{
+    lcb_RESPCALLBACK old = Mock::instance(instance).callback;
+    Mock::instance(instance).callback = callback;
+    return old;
+}
+
+void lcb_sched_enter(lcb_t) {}
+void lcb_sched_leave(lcb_t) {}
+void lcb_sched_fail(lcb_t) {}
+
+lcb_error_t lcb_get3(lcb_t instance, const void *cookie, const lcb_CMDGET *cmd)
+{
+    return Mock::queue(instance, LCB_CALLBACK_GET, cookie, cmd->key);
+}
+
+lcb_error_t lcb_rget3(lcb_t instance, const void *cookie, const lcb_CMDGETREPLICA *cmd)
+{
+    return Mock::queue(instance, LCB_CALLBACK_GETREPLICA, cookie, cmd->key);
+}
+
+lcb_timer_t lcb_timer_create(lcb_t instance, const void *cookie, lcb_U32, int periodic,
+    lcb_timer_callback callback, lcb_error_t *err)
+{
+    Mock::Timer *timer = new Mock::Timer();
+    timer->cookie = cookie;
+    timer->periodic = periodic != 0;
+    timer->callback = callback;
+    Mock::instance(instance).timers.insert(timer);
+    *err = LCB_SUCCESS;
+    return reinterpret_cast<lcb_timer_t>(timer);
+}
+
+lcb_error_t lcb_timer_destroy(lcb_t instance, lcb_timer_t timer)
+{
+    Mock::Timer *t = reinterpret_cast<Mock::Timer*>(timer);
+    if (Mock::instance(instance).timers.erase(t)) {
+        delete t;
+    }
+    return LCB_SUCCESS;
+}
+
+void lcb_breakout(lcb_t instance) { Mock::instance(instance).broke = true; }
+
+lcb_error_t lcb_wait3(lcb_t lcb, int)
+{
+    Mock::Instance& inst = Mock::instance(lcb);
+    inst.broke = false;
+    while (!inst.broke && !inst.pending.empty()) {
+        auto next = inst.pending.begin();
+        while (next != inst.pending.end() && next->held) {
+            ++next;
+        }
+        if (next == inst.pending.end()) {
+            // Only slow requests are left: time passes
+            size_t npending = inst.pending.size();
+            bool fired = Mock::fire_timers(lcb);
+            if (inst.broke || (fired && inst.pending.size() != npending)) {
+                continue;
+            }
+            next = inst.pending.begin();
+            inst.released++;
+        }
+        Mock::Request req = *next;
+        inst.pending.erase(next);
+        Mock::respond(lcb, req);
+    }
+    inst.broke = false;
+    return LCB_SUCCESS;
+}
+
+void lcb_backbuf_ref(lcb_BACKBUF) {}
+void lcb_backbuf_unref(lcb_BACKBUF) {}
+
+} // extern "C"
+
+#endif
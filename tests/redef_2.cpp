@@ -1,3 +1,10 @@
 #include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/pool.h>
+#include <libcouchbase/couchbase++/async.h>
+#include <libcouchbase/couchbase++/rowstream.h>
+#include <libcouchbase/couchbase++/jsonview.h>
+#include <libcouchbase/couchbase++/bulk.h>
+#include <libcouchbase/couchbase++/rowmap.h>
+#include <libcouchbase/couchbase++/columnar.h>
 
 int main(int, char**) {return 0;}
@@ -0,0 +1,30 @@
+#ifndef LCB_PLUSPLUS_TESTS_RESPONSES_H
+#define LCB_PLUSPLUS_TESTS_RESPONSES_H
+
+#include <libcouchbase/couchbase++.h>
+#include <cstring>
+#include <string>
+
+// Client used to deliver hand-built responses. It is never connected.
+inline Couchbase::Client&
+test_client()
+{
+    static Couchbase::Client client;
+    return client;
+}
+
+// Deliver a successful get response, as if received from the server, with
+// the value copied out of `value`
+inline void
+make_get_response(Couchbase::GetResponse& resp, const std::string& value, bool compressed = false)
+{
+    lcb_RESPGET raw;
+    memset(&raw, 0, sizeof raw);
+    raw.rc = LCB_SUCCESS;
+    raw.value = value.data();
+    raw.nvalue = value.size();
+    raw.datatype = compressed ? LCB_VALUE_F_SNAPPYCOMP : 0;
+    resp.handle_response(test_client(), LCB_CALLBACK_GET, reinterpret_cast<lcb_RESPBASE*>(&raw));
+}
+
+#endif
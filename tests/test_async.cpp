@@ -0,0 +1,50 @@
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/async.h>
+#include <future>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "mock_lcb.h"
+
+using namespace Couchbase;
+
+// Gets submitted before connect() are all scheduled in the I/O thread's
+// first pass, so the ones for the same key are in flight together
+static void
+get_all(bool coalesce, const std::string& key)
+{
+    AsyncClient client;
+    client.coalesce_gets(coalesce);
+    std::vector<std::future<GetResponse>> futures;
+    for (size_t ii = 0; ii < 4; ii++) {
+        futures.push_back(client.get(key));
+    }
+    futures.push_back(client.get("other"));
+    CHECK(client.connect().success());
+
+    for (size_t ii = 0; ii < 4; ii++) {
+        GetResponse resp = futures[ii].get();
+        CHECK(resp.status().success());
+        CHECK(resp.value().to_string() == "value");
+    }
+    CHECK(futures[4].get().status() == LCB_KEY_ENOENT);
+}
+
+static void
+test_coalesce()
+{
+    Mock::server().values["a"] = "value";
+    Mock::server().values["b"] = "value";
+
+    get_all(true, "a");
+    CHECK(Mock::server().gets["a"] == 1);
+
+    get_all(false, "b");
+    CHECK(Mock::server().gets["b"] == 4);
+}
+
+int main(int, char**)
+{
+    test_coalesce();
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <libcouchbase/couchbase++.h>
+#include <memory>
+#include "check.h"
+
+using Couchbase::Internal::ResponseArena;
+
+static void
+test_grow()
+{
+    ResponseArena<int> arena(4);
+    int *first = &arena.alloc();
+    *first = 0;
+    for (int ii = 1; ii < 10; ii++) {
+        arena.alloc() = ii;
+    }
+    CHECK(arena.size() == 10);
+
+    // Growing into new chunks does not move existing elements
+    CHECK(first == &arena.at(0));
+
+    int expected = 0;
+    for (auto it = arena.begin(); it != arena.end(); ++it) {
+        CHECK(*it == expected++);
+    }
+    CHECK(expected == 10);
+}
+
+static void
+test_reset()
+{
+    ResponseArena<std::shared_ptr<int>> arena(4);
+    std::shared_ptr<int> held(new int(42));
+    std::shared_ptr<int> *first = &arena.alloc();
+    *first = held;
+    arena.alloc() = held;
+    CHECK(held.use_count() == 3);
+
+    // Resetting releases what the elements hold, but keeps their storage
+    arena.reset();
+    CHECK(arena.size() == 0);
+    CHECK(arena.begin() == arena.end());
+    CHECK(held.use_count() == 1);
+    CHECK(&arena.alloc() == first);
+}
+
+static void
+test_reserve()
+{
+    ResponseArena<int> arena(4);
+    arena.reserve(9);
+    int *first = &arena.alloc();
+    for (int ii = 1; ii < 12; ii++) {
+        arena.alloc();
+    }
+    CHECK(first == &arena.at(0));
+
+    // A zero chunk size is treated as one
+    ResponseArena<int> tiny(0);
+    tiny.alloc() = 1;
+    tiny.alloc() = 2;
+    CHECK(tiny.at(0) == 1 && tiny.at(1) == 2);
+}
+
+int main(int, char**)
+{
+    test_grow();
+    test_reset();
+    test_reserve();
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <libcouchbase/couchbase++.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "check.h"
+#include "responses.h"
+
+using namespace Couchbase;
+
+static void
+insert(ReadCache& cache, const std::string& key, const std::string& value, uint32_t ttl = 0)
+{
+    GetResponse resp;
+    make_get_response(resp, value);
+    cache.insert(key.c_str(), key.size(), resp, ttl);
+}
+
+static bool
+cached(ReadCache& cache, const std::string& key)
+{
+    return cache.find(key.c_str(), key.size()) != NULL;
+}
+
+static void
+test_hits()
+{
+    ReadCache cache;
+    CHECK(!cached(cache, "foo"));
+    insert(cache, "foo", "bar");
+    CHECK(cache.size() == 1);
+
+    const GetResponse *resp = cache.find("foo", 3);
+    CHECK(resp != NULL);
+    CHECK(resp->value().to_string() == "bar");
+
+    // Hits share the cached copy
+    const char *buf = resp->valuebuf();
+    CHECK(cache.find("foo", 3)->valuebuf() == buf);
+    CHECK(cache.stats().hits == 2);
+    CHECK(cache.stats().misses == 1);
+
+    // Re-inserting a key replaces its entry
+    size_t bytes = cache.bytes();
+    insert(cache, "foo", "baz");
+    CHECK(cache.size() == 1);
+    CHECK(cache.bytes() == bytes);
+    CHECK(cache.find("foo", 3)->value().to_string() == "baz");
+
+    cache.invalidate("foo", 3);
+    CHECK(!cached(cache, "foo"));
+    CHECK(cache.size() == 0);
+    CHECK(cache.bytes() == 0);
+    CHECK(cache.stats().invalidations == 2);
+
+    // Invalidating a key which is not cached is not counted
+    cache.invalidate("foo", 3);
+    CHECK(cache.stats().invalidations == 2);
+
+    insert(cache, "a", "1");
+    insert(cache, "b", "2");
+    cache.clear();
+    CHECK(cache.size() == 0);
+    CHECK(cache.bytes() == 0);
+    CHECK(!cached(cache, "a"));
+}
+
+static void
+test_ttl()
+{
+    ReadCache cache(1024 * 1024, 60000);
+    insert(cache, "short", "x", 1);
+    insert(cache, "long", "x");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // Expired entries are removed when looked up
+    CHECK(!cached(cache, "short"));
+    CHECK(cache.size() == 1);
+    CHECK(cached(cache, "long"));
+    CHECK(cache.stats().misses == 1);
+
+    ReadCache expiring(1024 * 1024, 1);
+    insert(expiring, "key", "x");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(!cached(expiring, "key"));
+    CHECK(expiring.bytes() == 0);
+}
+
+static void
+test_clock()
+{
+    // Room for exactly three entries with two byte keys and values
+    GetResponse probe;
+    make_get_response(probe, "v1");
+    ReadCache sizing;
+    sizing.insert("k1", 2, probe);
+    size_t cost = sizing.bytes();
+    ReadCache cache(cost * 3);
+
+    insert(cache, "k1", "v1");
+    insert(cache, "k2", "v2");
+    insert(cache, "k3", "v3");
+    CHECK(cache.size() == 3);
+    CHECK(cache.stats().evictions == 0);
+
+    // k1 was referenced, so it gets a second chance and k2 is evicted
+    CHECK(cached(cache, "k1"));
+    insert(cache, "k4", "v4");
+    CHECK(cache.size() == 3);
+    CHECK(cache.bytes() == cost * 3);
+    CHECK(cache.stats().evictions == 1);
+    CHECK(!cached(cache, "k2"));
+
+    // The hand moves on to k3, which was never referenced
+    insert(cache, "k5", "v5");
+    CHECK(cache.stats().evictions == 2);
+    CHECK(!cached(cache, "k3"));
+    CHECK(cached(cache, "k1"));
+    CHECK(cached(cache, "k4"));
+    CHECK(cached(cache, "k5"));
+
+    // Entries larger than the whole cache are not cached at all
+    insert(cache, "big", std::string(cost * 3, 'x'));
+    CHECK(!cached(cache, "big"));
+    CHECK(cache.size() == 3);
+    CHECK(cache.stats().evictions == 2);
+}
+
+int main(int, char**)
+{
+    test_hits();
+    test_ttl();
+    test_clock();
+    return 0;
+}
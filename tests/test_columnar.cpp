@@ -0,0 +1,130 @@
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/columnar.h>
+#include <string>
+#include "check.h"
+
+using namespace Couchbase;
+
+enum { ID, SCORE, OK, NAME };
+
+static void
+decode(Internal::ColumnDecoder& decoder, ColumnBatch& batch, const std::string& row)
+{
+    decoder.decode(JsonView(row.data(), row.data() + row.size()), batch);
+}
+
+static void
+test_nulls()
+{
+    ColumnSchema schema;
+    schema.add("id", ColumnSchema::INT)
+        .add("score", ColumnSchema::DOUBLE)
+        .add("ok", ColumnSchema::BOOL)
+        .add("name", ColumnSchema::STRING);
+    Internal::ColumnDecoder decoder(schema);
+    ColumnBatch batch;
+    decoder.reset(batch, 4);
+    CHECK(batch.columns() == 4);
+
+    // 0: every column present
+    decode(decoder, batch, "{\"id\": 1, \"score\": 2.5, \"ok\": true, \"name\": \"one\"}");
+    // 1: every column missing
+    decode(decoder, batch, "{\"other\": 1}");
+    // 2: every column null
+    decode(decoder, batch, "{\"id\": null, \"score\": null, \"ok\": null, \"name\": null}");
+    // 3: wrong types, in a different order
+    decode(decoder, batch, "{\"name\": {\"a\": [1]}, \"ok\": 1, \"score\": \"2\", \"id\": false}");
+    // 4: not an object
+    decode(decoder, batch, "[1, 2, 3]");
+    // 5: escaped string, integer in a double column, duplicate member
+    decode(decoder, batch, "{\"name\": \"a\\tb\", \"score\": 3, \"id\": 5, \"id\": 6, \"ok\": false}");
+
+    CHECK(batch.size() == 6);
+    for (size_t col = 0; col < batch.columns(); col++) {
+        CHECK(batch.column(col).valid.size() == 6);
+    }
+    CHECK(batch.column(ID).ints.size() == 6);
+    CHECK(batch.column(SCORE).doubles.size() == 6);
+    CHECK(batch.column(OK).bools.size() == 6);
+    CHECK(batch.column(NAME).offsets.size() == 7);
+
+    const uint8_t expect_valid[][6] = {
+        { 1, 0, 0, 0, 0, 1 }, // id
+        { 1, 0, 0, 0, 0, 1 }, // score
+        { 1, 0, 0, 0, 0, 1 }, // ok
+        { 1, 0, 0, 1, 0, 1 }, // name: non-strings are kept as raw JSON
+    };
+    for (size_t col = 0; col < 4; col++) {
+        for (size_t row = 0; row < 6; row++) {
+            CHECK(batch.valid(col)[row] == expect_valid[col][row]);
+        }
+    }
+
+    // Invalid values are stored as zero, or as an empty string
+    for (size_t row = 1; row < 5; row++) {
+        CHECK(batch.ints(ID)[row] == 0);
+        CHECK(batch.doubles(SCORE)[row] == 0);
+        CHECK(batch.bools(OK)[row] == 0);
+    }
+    CHECK(batch.string(NAME, 1).empty());
+    CHECK(batch.string(NAME, 2).empty());
+    CHECK(batch.string(NAME, 4).empty());
+
+    CHECK(batch.ints(ID)[0] == 1);
+    CHECK(batch.doubles(SCORE)[0] == 2.5);
+    CHECK(batch.bools(OK)[0] == 1);
+    CHECK(batch.string(NAME, 0).to_string() == "one");
+    CHECK(batch.string(NAME, 3).to_string() == "{\"a\": [1]}");
+
+    // The first of duplicate members wins
+    CHECK(batch.ints(ID)[5] == 5);
+    CHECK(batch.doubles(SCORE)[5] == 3);
+    CHECK(batch.bools(OK)[5] == 0);
+    CHECK(batch.string(NAME, 5).to_string() == "a\tb");
+
+    // Only valid values are counted
+    CHECK(batch.bytes() == 2 * (8 + 8 + 1) + (3 + 4) + (10 + 4) + (3 + 4));
+
+    decoder.reset(batch, 4);
+    CHECK(batch.size() == 0);
+    CHECK(batch.bytes() == 0);
+    CHECK(batch.column(NAME).offsets.size() == 1);
+}
+
+static void
+test_integral()
+{
+    ColumnSchema schema;
+    schema.add("id", ColumnSchema::INT);
+    Internal::ColumnDecoder decoder(schema);
+    ColumnBatch batch;
+    decoder.reset(batch, 8);
+
+    const char *values[] = {
+        "2.5", "-0.5", "1e-1", "1e30", "2.0", "2e3", "-7", "99999999999999999999"
+    };
+    for (size_t ii = 0; ii < 8; ii++) {
+        decode(decoder, batch, std::string("{\"id\": ") + values[ii] + "}");
+    }
+
+    // Fractional and out-of-range values are invalid, not truncated
+    const uint8_t expect_valid[] = { 0, 0, 0, 0, 1, 1, 1, 1 };
+    for (size_t row = 0; row < 8; row++) {
+        CHECK(batch.valid(0)[row] == expect_valid[row]);
+    }
+    for (size_t row = 0; row < 4; row++) {
+        CHECK(batch.ints(0)[row] == 0);
+    }
+    CHECK(batch.ints(0)[4] == 2);
+    CHECK(batch.ints(0)[5] == 2000);
+    CHECK(batch.ints(0)[6] == -7);
+    CHECK(batch.ints(0)[7] == INT64_MAX);
+    CHECK(batch.bytes() == 4 * 8);
+}
+
+int main(int, char**)
+{
+    test_nulls();
+    test_integral();
+    return 0;
+}
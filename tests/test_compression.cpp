@@ -0,0 +1,145 @@
+#include <libcouchbase/couchbase++.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "counting_resource.h"
+#include "responses.h"
+
+using namespace Couchbase;
+
+// Stands in for Snappy: a value is encoded as its length followed by the
+// single character it repeats
+class RepeatDecompressor : public Decompressor {
+public:
+    mutable size_t calls = 0;
+
+    bool uncompressed_length(const char *in, size_t nin, size_t& nout) const override {
+        if (nin != 2) {
+            return false;
+        }
+        nout = static_cast<unsigned char>(in[0]);
+        return true;
+    }
+    bool decompress(const char *in, size_t, char *out, size_t nout) const override {
+        calls++;
+        memset(out, in[1], nout);
+        return true;
+    }
+};
+
+static void
+test_lazy()
+{
+    RepeatDecompressor decomp;
+    CountingResource resource;
+    test_client().decompressor(&decomp);
+    test_client().memory_resource(&resource);
+    {
+        GetResponse resp;
+        make_get_response(resp, std::string("\x05x", 2), true);
+
+        // Nothing is decompressed until the value is accessed
+        CHECK(resp.compressed());
+        CHECK(decomp.calls == 0);
+        size_t live = resource.live;
+
+        CHECK(resp.valuesize() == 5);
+        CHECK(resp.value().to_string() == "xxxxx");
+        CHECK(!resp.compressed());
+        CHECK(decomp.calls == 1);
+
+        // The decompressed copy comes from the client's resource
+        CHECK(resource.live > live);
+
+        // ... and is only made once, and shared with value handles
+        SharedValue shared = resp.shared_value();
+        CHECK(resp.valuebuf() == shared.data());
+        CHECK(decomp.calls == 1);
+
+        // Values which did not arrive compressed are left alone
+        GetResponse plain;
+        make_get_response(plain, "plain", false);
+        CHECK(!plain.compressed());
+        CHECK(plain.value().to_string() == "plain");
+        CHECK(decomp.calls == 1);
+
+        // Invalid input is returned as it was received
+        GetResponse bad;
+        make_get_response(bad, "bad", true);
+        CHECK(bad.value().to_string() == "bad");
+        CHECK(decomp.calls == 1);
+    }
+    CHECK(resource.live == 0);
+    test_client().memory_resource(NULL);
+
+    // Without a decompressor, values are returned compressed
+    test_client().decompressor(NULL);
+    GetResponse resp;
+    make_get_response(resp, std::string("\x05x", 2), true);
+    CHECK(resp.compressed());
+    CHECK(resp.valuesize() == 2);
+    CHECK(resp.compressed());
+    CHECK(decomp.calls == 1);
+}
+
+static void
+test_shared()
+{
+    RepeatDecompressor decomp;
+    ReadCache cache;
+    test_client().decompressor(&decomp);
+    test_client().read_cache(&cache);
+    size_t plain_cost;
+    {
+        GetResponse resp;
+        make_get_response(resp, "xx");
+        cache.insert("baz", 3, resp, 0);
+        plain_cost = cache.bytes();
+        make_get_response(resp, std::string("\x05x", 2), true);
+        cache.insert("foo", 3, resp, 0);
+        make_get_response(resp, std::string("\x40y", 2), true);
+        cache.insert("bar", 3, resp, 0);
+    }
+    // The decompressed size is charged up front, as any hit may make it
+    CHECK(cache.bytes() == 3 * plain_cost + 5 + 0x40);
+    CHECK(decomp.calls == 0);
+
+    // Cache hits share one decompressed value
+    GetResponse first = test_client().get(GetCommand("foo"));
+    GetResponse second = test_client().get(GetCommand("foo"));
+    CHECK(cache.stats().hits == 2);
+    CHECK(first.value().to_string() == "xxxxx");
+    CHECK(second.value().to_string() == "xxxxx");
+    CHECK(first.valuebuf() == second.valuebuf());
+    CHECK(cache.find("foo", 3)->valuebuf() == first.valuebuf());
+    CHECK(decomp.calls == 1);
+
+    // ... even when they are first read from several threads at once
+    std::vector<GetResponse> hits;
+    for (size_t ii = 0; ii < 8; ii++) {
+        hits.push_back(test_client().get(GetCommand("bar")));
+        CHECK(hits.back().compressed());
+    }
+    std::vector<std::thread> threads;
+    for (auto& hit : hits) {
+        threads.emplace_back([&hit]() { CHECK(hit.valuesize() == 0x40); });
+    }
+    for (auto& thr : threads) {
+        thr.join();
+    }
+    CHECK(decomp.calls == 2);
+    for (auto& hit : hits) {
+        CHECK(hit.valuebuf() == hits[0].valuebuf());
+    }
+
+    test_client().read_cache(NULL);
+    test_client().decompressor(NULL);
+}
+
+int main(int, char**)
+{
+    test_lazy();
+    test_shared();
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <libcouchbase/couchbase++.h>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "mock_lcb.h"
+
+using namespace Couchbase;
+
+static Mock::Instance&
+instance(Client& client)
+{
+    return Mock::instance(client.handle());
+}
+
+static void
+test_fast()
+{
+    Client client;
+    CHECK(client.connect().success());
+
+    // The active node answers before the timer, so no replica is read
+    GetResponse resp = client.get_hedged(GetCommand("fast"), 1000);
+    CHECK(resp.status().success());
+    CHECK(!resp.from_replica());
+    CHECK(resp.value().to_string() == "1");
+    CHECK(Mock::server().replica_gets["fast"] == 0);
+    CHECK(instance(client).pending.empty());
+    CHECK(instance(client).timers.empty());
+}
+
+static void
+test_slow()
+{
+    Client client;
+    CHECK(client.connect().success());
+
+    // The replica answers while the active node is slow
+    GetResponse resp = client.get_hedged(GetCommand("slow"), 1000);
+    CHECK(resp.status().success());
+    CHECK(resp.from_replica());
+    CHECK(resp.value().to_string() == "2");
+    CHECK(Mock::server().replica_gets["slow"] == 1);
+    CHECK(instance(client).pending.size() == 1);
+
+    // Later operations do not wait for the slow request
+    CHECK(client.get(GetCommand("fast")).value().to_string() == "1");
+    CHECK(client.get(GetCommand("fast")).value().to_string() == "1");
+    std::vector<GetResponse> multi = client.get_multi({ "fast", "other" });
+    CHECK(multi[0].value().to_string() == "1");
+    CHECK(multi[1].value().to_string() == "3");
+    CHECK(instance(client).released == 0);
+    CHECK(instance(client).pending.size() == 1);
+
+    // It is discarded when it does arrive
+    client.wait();
+    CHECK(instance(client).released == 1);
+    CHECK(instance(client).pending.empty());
+    CHECK(client.get(GetCommand("other")).value().to_string() == "3");
+
+    // A client may be destroyed while a slow request is out
+    client.get_hedged(GetCommand("slow"), 1000);
+    CHECK(instance(client).pending.size() == 1);
+}
+
+int main(int, char**)
+{
+    Mock::server().values["fast"] = "1";
+    Mock::server().values["slow"] = "2";
+    Mock::server().values["other"] = "3";
+    Mock::server().slow.insert("slow");
+    test_fast();
+    test_slow();
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/jsonview.h>
+#include <string>
+#include "check.h"
+
+using namespace Couchbase;
+
+static JsonView
+view(const std::string& s)
+{
+    return JsonView(s.data(), s.data() + s.size());
+}
+
+static void
+test_scalars()
+{
+    CHECK(view("null").is_null());
+    CHECK(view("true").as_bool());
+    CHECK(!view("false").as_bool(true));
+    CHECK(view(" 42 ").as_int() == 42);
+    CHECK(view("-7").as_int() == -7);
+    CHECK(view("1.5e1").as_int() == 15);
+    CHECK(view("2.25").as_double() == 2.25);
+
+    // Accessors of the wrong type return their default
+    CHECK(view("\"1\"").as_int(-1) == -1);
+    CHECK(view("1").as_bool(true));
+    CHECK(view("1").as_buffer().empty());
+
+    // Integers at and beyond the limits of int64_t saturate
+    CHECK(view("9223372036854775807").as_int() == INT64_MAX);
+    CHECK(view("-9223372036854775808").as_int() == INT64_MIN);
+    CHECK(view("9223372036854775808").as_int() == INT64_MAX);
+    CHECK(view("-9223372036854775809").as_int() == INT64_MIN);
+    CHECK(view("184467440737095516160").as_int() == INT64_MAX);
+    CHECK(view("-1e30").as_int() == INT64_MIN);
+    CHECK(view("-0").as_int() == 0);
+
+    // Unrecognised scalars are malformed, not numbers or booleans
+    CHECK(!view("abc").valid());
+    CHECK(!view("truex").valid());
+    CHECK(!view("fals").valid());
+    CHECK(!view("nul").valid());
+    CHECK(!view("+1").valid());
+    CHECK(!view("{\"a\": bogus}")["a"].valid());
+    CHECK(view("{\"a\": bogus, \"b\": 1}")["b"].as_int() == 1);
+
+    CHECK(!view("").valid());
+    CHECK(!view("   ").valid());
+    CHECK(!view("\"unterminated").valid());
+    CHECK(!view("[1, 2").valid());
+}
+
+static void
+test_strings()
+{
+    std::string s = "\"plain\"";
+    CHECK(view(s).as_buffer().to_string() == "plain");
+    CHECK(!view(s).has_escapes());
+    CHECK(view("\"\"").as_string().empty());
+
+    CHECK(view("\"a\\\"b\"").as_string() == "a\"b");
+    CHECK(view("\"a\\\\\"").as_string() == "a\\");
+    CHECK(view("\"\\/\\b\\f\\n\\r\\t\"").as_string() == "/\b\f\n\r\t");
+    CHECK(view("\"a\\nb\"").has_escapes());
+
+    // Escapes are not processed by as_buffer()
+    CHECK(view("\"a\\nb\"").as_buffer().to_string() == "a\\nb");
+
+    // One, two and three byte UTF-8 sequences
+    CHECK(view("\"\\u0041\"").as_string() == "A");
+    CHECK(view("\"\\u00e9\"").as_string() == "\xC3\xA9");
+    CHECK(view("\"\\u20AC\"").as_string() == "\xE2\x82\xAC");
+
+    // A surrogate pair is combined into a single four byte sequence
+    CHECK(view("\"\\ud83d\\ude00\"").as_string() == "\xF0\x9F\x98\x80");
+    CHECK(view("\"x\\uD83D\\uDE00y\"").as_string() == "x\xF0\x9F\x98\x80y");
+
+    // Truncated escapes stop decoding rather than reading past the end
+    CHECK(view("\"ab\\u12\"").as_string() == "ab");
+}
+
+static void
+test_containers()
+{
+    std::string doc =
+        "{\"id\": 1, \"name\": \"x\\\"}\", \"tags\": [\"a\", [1, {\"b\": 2}], \"]\"],"
+        " \"nested\": {\"inner\": {\"deep\": [true, null]}}, \"empty\": {}, \"none\": [ ]}";
+    JsonView v = view(doc);
+    CHECK(v.type() == JsonView::OBJECT);
+    CHECK(v.size() == 6);
+    CHECK(v["id"].as_int() == 1);
+
+    // Brackets and quotes inside strings do not confuse the scanner
+    CHECK(v["name"].as_string() == "x\"}");
+    JsonView tags = v["tags"];
+    CHECK(tags.type() == JsonView::ARRAY);
+    CHECK(tags.size() == 3);
+    CHECK(tags[1][1]["b"].as_int() == 2);
+    CHECK(tags[2].as_string() == "]");
+    CHECK(!tags[3].valid());
+
+    CHECK(v["nested"]["inner"]["deep"][0].as_bool());
+    CHECK(v["nested"]["inner"]["deep"][1].is_null());
+
+    // Empty containers
+    CHECK(v["empty"].type() == JsonView::OBJECT);
+    CHECK(v["empty"].size() == 0);
+    CHECK(v["empty"].begin() == v["empty"].end());
+    CHECK(v["none"].type() == JsonView::ARRAY);
+    CHECK(v["none"].size() == 0);
+    CHECK(!v["none"][0].valid());
+
+    // Missing members and lookups on the wrong type
+    CHECK(!v["missing"].valid());
+    CHECK(!v[0].valid());
+    CHECK(!v["id"]["x"].valid());
+
+    // Iteration yields names (raw) and values in order
+    const char *names[] = { "id", "name", "tags", "nested", "empty", "none" };
+    size_t ix = 0;
+    for (auto& m : v) {
+        CHECK(m.name.to_string() == names[ix++]);
+    }
+    CHECK(ix == 6);
+
+    ix = 0;
+    for (auto& m : tags) {
+        CHECK(m.name.empty());
+        CHECK(m.value.valid());
+        ix++;
+    }
+    CHECK(ix == 3);
+
+    // The raw text of a member points into the original buffer
+    Buffer raw = v["nested"]["inner"].raw();
+    CHECK(raw.data() > doc.data() && raw.data() < doc.data() + doc.size());
+    CHECK(raw.to_string() == "{\"deep\": [true, null]}");
+}
+
+int main(int, char**)
+{
+    test_scalars();
+    test_strings();
+    test_containers();
+    return 0;
+}
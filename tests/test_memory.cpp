@@ -0,0 +1,89 @@
+#include <libcouchbase/couchbase++/memory.h>
+#include <cstring>
+#include "check.h"
+#include "counting_resource.h"
+
+using namespace Couchbase;
+
+static bool
+aligned(void *p, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+static void
+test_monotonic()
+{
+    CountingResource upstream;
+    {
+        MonotonicResource arena(1024, &upstream);
+        CHECK(upstream.allocs == 0);
+
+        // Small allocations are carved out of a single block
+        char *a = static_cast<char*>(arena.allocate(10, 1));
+        char *b = static_cast<char*>(arena.allocate(10, 1));
+        CHECK(upstream.allocs == 1);
+        CHECK(b == a + 10);
+
+        // Padding is inserted to honour the alignment
+        void *c = arena.allocate(8, 8);
+        CHECK(aligned(c, 8));
+        CHECK(static_cast<char*>(c) < b + 10 + 8);
+        CHECK(upstream.allocs == 1);
+
+        // Deallocation does nothing
+        arena.deallocate(a, 10, 1);
+        CHECK(upstream.live == 1);
+
+        // An allocation larger than the block size gets a block of its own
+        void *big = arena.allocate(4096, 16);
+        CHECK(aligned(big, 16));
+        CHECK(upstream.allocs == 2);
+        CHECK(upstream.live_bytes >= 1024 + 4096);
+        memset(big, 0, 4096);
+
+        // Filling the current block starts a new one
+        arena.allocate(1024, 1);
+        CHECK(upstream.allocs == 3);
+
+        arena.release();
+        CHECK(upstream.live == 0);
+
+        // The resource can be reused after being released
+        arena.allocate(10, 1);
+        CHECK(upstream.live == 1);
+    }
+    // ... and returns everything when destroyed
+    CHECK(upstream.live == 0);
+    CHECK(upstream.live_bytes == 0);
+}
+
+static void
+test_make_buffer()
+{
+    CountingResource resource;
+    {
+        std::shared_ptr<char> buf = Internal::make_buffer(&resource, 100);
+        // Both the buffer and the shared_ptr control block come from the
+        // resource
+        CHECK(resource.live == 2);
+        memset(buf.get(), 'x', 100);
+
+        std::shared_ptr<char> empty = Internal::make_buffer(&resource, 0);
+        CHECK(empty.get() != NULL);
+        CHECK(resource.live == 4);
+    }
+    CHECK(resource.live == 0);
+    CHECK(resource.live_bytes == 0);
+
+    // A NULL resource means the default
+    std::shared_ptr<char> buf = Internal::make_buffer(NULL, 10);
+    CHECK(buf.get() != NULL);
+}
+
+int main(int, char**)
+{
+    test_monotonic();
+    test_make_buffer();
+    return 0;
+}
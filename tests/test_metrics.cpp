@@ -0,0 +1,79 @@
+#include <libcouchbase/couchbase++/metrics.h>
+#include "check.h"
+
+using namespace Couchbase;
+
+// The value reported for a single recorded latency
+static uint64_t
+reported(uint64_t ns)
+{
+    LatencyHistogram h;
+    h.record(ns);
+    return h.p50();
+}
+
+static void
+test_buckets()
+{
+    // Small values are recorded exactly
+    for (uint64_t v = 0; v < 32; v++) {
+        CHECK(reported(v) == v);
+    }
+
+    // Larger ones are reported as the upper bound of their bucket, which
+    // is at most 1/16th above the true value
+    for (uint64_t v = 32; v < (uint64_t(1) << 40); v += v / 7 + 1) {
+        uint64_t r = reported(v);
+        CHECK(r >= v);
+        CHECK(r - v <= v / 16);
+    }
+    for (unsigned bit = 5; bit < 40; bit++) {
+        uint64_t pow2 = uint64_t(1) << bit;
+        CHECK(reported(pow2 - 1) == pow2 - 1);
+        CHECK(reported(pow2) == pow2 + (pow2 >> 4) - 1);
+    }
+
+    // Values beyond the range all land in the last bucket
+    uint64_t last = (uint64_t(1) << 40) - 1;
+    CHECK(reported(last) == last);
+    CHECK(reported(uint64_t(1) << 50) == last);
+    CHECK(reported(~uint64_t(0)) == last);
+}
+
+static void
+test_percentiles()
+{
+    LatencyHistogram h;
+    CHECK(h.count() == 0);
+    CHECK(h.p50() == 0);
+
+    for (uint64_t v = 1; v <= 100; v++) {
+        h.record(v);
+    }
+    CHECK(h.count() == 100);
+    CHECK(h.percentile(0) == 1);
+    CHECK(h.p50() >= 50 && h.p50() <= 53);
+    CHECK(h.p99() == 99);
+    CHECK(h.percentile(100) >= 100 && h.percentile(100) <= 106);
+
+    // Percentiles are by count, not by value
+    for (int ii = 0; ii < 900; ii++) {
+        h.record(10);
+    }
+    CHECK(h.p50() == 10);
+    CHECK(h.percentile(90) == 10);
+    CHECK(h.p99() > 10);
+
+    h.reset();
+    CHECK(h.count() == 0);
+    CHECK(h.p99() == 0);
+    h.record(7);
+    CHECK(h.p999() == 7);
+}
+
+int main(int, char**)
+{
+    test_buckets();
+    test_percentiles();
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/pool.h>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <utility>
+#include "check.h"
+
+using namespace Couchbase;
+
+// The clients are never connected: leasing them does not touch the network
+
+static void
+test_exhausted()
+{
+    ClientPool pool(3);
+    CHECK(pool.size() == 3);
+
+    // Every client is handed out once
+    std::set<Client*> seen;
+    ClientPool::Lease leases[3];
+    for (auto& lease : leases) {
+        CHECK(pool.try_acquire(lease));
+        CHECK(lease.valid());
+        seen.insert(&*lease);
+    }
+    CHECK(seen.size() == 3);
+
+    // ... after which none is available
+    ClientPool::Lease extra;
+    CHECK(!pool.try_acquire(extra));
+    CHECK(!extra.valid());
+
+    // Until one is returned
+    Client *returned = leases[1].operator->();
+    leases[1].release();
+    CHECK(!leases[1].valid());
+    CHECK(pool.try_acquire(extra));
+    CHECK(&*extra == returned);
+    CHECK(!pool.try_acquire(leases[1]));
+
+    bool threw = false;
+    try {
+        ClientPool empty(0);
+    } catch (Status& st) {
+        threw = st.errcode() == LCB_EINVAL;
+    }
+    CHECK(threw);
+}
+
+static void
+test_moved()
+{
+    ClientPool pool(1);
+    ClientPool::Lease lease = pool.acquire();
+    Client *client = &*lease;
+
+    // The client moves with the lease; the moved-from lease holds nothing,
+    // and destroying it does not return the client
+    ClientPool::Lease other(std::move(lease));
+    CHECK(!lease.valid());
+    CHECK(other.valid());
+    CHECK(&*other == client);
+    lease.release();
+    {
+        ClientPool::Lease gone(std::move(lease));
+        CHECK(!gone.valid());
+    }
+    ClientPool::Lease none;
+    CHECK(!pool.try_acquire(none));
+
+    // Assigning to a lease returns the client it held
+    other = std::move(lease);
+    CHECK(!other.valid());
+    CHECK(pool.try_acquire(none));
+    CHECK(&*none == client);
+}
+
+static void
+test_blocking()
+{
+    ClientPool pool(1);
+    ClientPool::Lease held = pool.acquire();
+    Client *client = &*held;
+
+    std::atomic<bool> acquired(false);
+    Client *got = NULL;
+    std::thread waiter([&]() {
+        ClientPool::Lease lease = pool.acquire();
+        got = &*lease;
+        acquired = true;
+    });
+
+    // The waiter blocks while the only client is leased ...
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!acquired);
+
+    // ... and is woken when it is returned
+    held.release();
+    waiter.join();
+    CHECK(acquired);
+    CHECK(got == client);
+
+    // Its lease was returned in turn
+    CHECK(pool.try_acquire(held));
+}
+
+int main(int, char**)
+{
+    test_exhausted();
+    test_moved();
+    test_blocking();
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <libcouchbase/couchbase++.h>
+#include <cstring>
+#include "check.h"
+
+using namespace Couchbase;
+
+static void
+test_delay()
+{
+    RetryPolicy policy(5, 1000, 8000);
+
+    // Jitter places the delay between half of and the full backoff
+    CHECK(policy.delay(1, 0) == 500);
+    CHECK(policy.delay(1, 500) == 1000);
+    CHECK(policy.delay(1, 501) == 500);
+    for (uint32_t r = 0; r < 5000; r += 37) {
+        uint32_t d = policy.delay(1, r);
+        CHECK(d >= 500 && d <= 1000);
+    }
+
+    // The backoff doubles with each attempt ...
+    CHECK(policy.delay(2, 0) == 1000);
+    CHECK(policy.delay(2, 1000) == 2000);
+    CHECK(policy.delay(3, 0) == 2000);
+    CHECK(policy.delay(4, 4000) == 8000);
+
+    // ... up to the maximum, however many attempts were made
+    CHECK(policy.delay(5, 0) == 4000);
+    CHECK(policy.delay(5, 4000) == 8000);
+    CHECK(policy.delay(1000, 0xffffffff) <= 8000);
+    CHECK(policy.delay(1000, 0) == 4000);
+
+    // An initial delay above the maximum is clamped too
+    RetryPolicy clamped(5, 10000, 2000);
+    CHECK(clamped.delay(1, 0) == 1000);
+    CHECK(clamped.delay(1, 1000) == 2000);
+
+    // Delays too small to halve get no jitter
+    RetryPolicy tiny(5, 1, 1);
+    CHECK(tiny.delay(1, 12345) == 0);
+    RetryPolicy none(5, 0, 1000);
+    CHECK(none.delay(3, 12345) == 0);
+}
+
+static void
+test_enabled()
+{
+    CHECK(!RetryPolicy().enabled());
+    CHECK(!RetryPolicy(1).enabled());
+    CHECK(RetryPolicy(2).enabled());
+}
+
+static void
+test_classification()
+{
+    using namespace Internal;
+    CHECK(retry_rejected(LCB_ETMPFAIL));
+    CHECK(retry_rejected(LCB_EBUSY));
+    CHECK(retry_rejected(LCB_ENOMEM));
+    CHECK(!retry_rejected(LCB_ETIMEDOUT));
+    CHECK(!retry_rejected(LCB_NETWORK_ERROR));
+    CHECK(!retry_rejected(LCB_KEY_ENOENT));
+
+    // Only reads and unconditional overwrites may be sent twice
+    lcb_CMDGET get;
+    memset(&get, 0, sizeof get);
+    CHECK(retry_idempotent(&get));
+    get.lock = 1;
+    CHECK(!retry_idempotent(&get));
+
+    lcb_CMDSTORE store;
+    memset(&store, 0, sizeof store);
+    CHECK(retry_idempotent(&store));
+    store.operation = LCB_SET;
+    CHECK(retry_idempotent(&store));
+    store.cas = 1234;
+    CHECK(!retry_idempotent(&store));
+    store.cas = 0;
+    store.operation = LCB_ADD;
+    CHECK(!retry_idempotent(&store));
+    store.operation = LCB_APPEND;
+    CHECK(!retry_idempotent(&store));
+
+    lcb_CMDREMOVE remove;
+    memset(&remove, 0, sizeof remove);
+    CHECK(!retry_idempotent(&remove));
+}
+
+int main(int, char**)
+{
+    test_delay();
+    test_enabled();
+    test_classification();
+    return 0;
+}
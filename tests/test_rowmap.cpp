@@ -0,0 +1,125 @@
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/rowmap.h>
+#include <string>
+#include "check.h"
+
+using namespace Couchbase;
+
+struct Geo {
+    double lat = 0;
+    double lon = 0;
+};
+LCB_CXX_ROW_FIELDS(Geo,
+    LCB_CXX_FIELD(Geo, lat),
+    LCB_CXX_FIELD(Geo, lon))
+
+struct Airport {
+    std::string name;
+    int64_t id = -1;
+    unsigned short runways = 0;
+    bool active = false;
+    std::string city;
+    Geo geo;
+    std::vector<std::string> codes;
+};
+LCB_CXX_ROW_FIELDS(Airport,
+    LCB_CXX_FIELD(Airport, name),
+    LCB_CXX_FIELD(Airport, id),
+    LCB_CXX_FIELD(Airport, runways),
+    LCB_CXX_FIELD(Airport, active),
+    LCB_CXX_NAMED_FIELD(Airport, city, "municipality"),
+    LCB_CXX_FIELD(Airport, geo),
+    LCB_CXX_FIELD(Airport, codes))
+
+struct Borrowed {
+    Buffer name;
+    std::vector<JsonView> extra;
+};
+LCB_CXX_ROW_FIELDS(Borrowed,
+    LCB_CXX_FIELD(Borrowed, name),
+    LCB_CXX_FIELD(Borrowed, extra))
+
+struct Outer {
+    std::string id;
+    std::vector<Borrowed> inner;
+};
+LCB_CXX_ROW_FIELDS(Outer,
+    LCB_CXX_FIELD(Outer, id),
+    LCB_CXX_FIELD(Outer, inner))
+
+// decode_rows() relies on this to reject types which refer to the row
+static_assert(!Internal::Borrows<Airport>::value, "Airport owns its data");
+static_assert(Internal::Borrows<Borrowed>::value, "Buffer borrows");
+static_assert(Internal::Borrows<Outer>::value, "nested borrows are found");
+static_assert(Internal::Borrows<std::vector<JsonView>>::value, "vectors of views borrow");
+
+static JsonView
+view(const std::string& s)
+{
+    return JsonView(s.data(), s.data() + s.size());
+}
+
+static void
+test_decode()
+{
+    std::string row =
+        "{\"name\": \"Schiphol \\\"AMS\\\"\", \"id\": 580, \"runways\": 6,"
+        " \"active\": true, \"municipality\": \"Amsterdam\", \"unknown\": {\"x\": [1]},"
+        " \"geo\": {\"lat\": 52.3, \"lon\": 4.75}, \"codes\": [\"AMS\", \"EHAM\"]}";
+    RowDecoder<Airport> decoder;
+    Airport a;
+    CHECK(decoder.decode(view(row), a));
+    CHECK(a.name == "Schiphol \"AMS\"");
+    CHECK(a.id == 580);
+    CHECK(a.runways == 6);
+    CHECK(a.active);
+    CHECK(a.city == "Amsterdam");
+    CHECK(a.geo.lat == 52.3 && a.geo.lon == 4.75);
+    CHECK(a.codes.size() == 2 && a.codes[0] == "AMS" && a.codes[1] == "EHAM");
+
+    // Members may come in any order, and missing ones are left untouched
+    Airport b;
+    b.name = "unchanged";
+    CHECK(decoder.decode(view("{\"codes\": [], \"id\": 7, \"municipality\": \"X\"}"), b));
+    CHECK(b.name == "unchanged");
+    CHECK(b.id == 7);
+    CHECK(b.city == "X");
+    CHECK(b.codes.empty());
+
+    // ... including after the decoder has learned a different order
+    Airport c;
+    CHECK(decoder.decode(view(row), c));
+    CHECK(c.name == a.name && c.id == a.id && c.city == a.city);
+    CHECK(c.geo.lon == 4.75 && c.codes.size() == 2);
+
+    // Values of the wrong type leave the member as it was
+    Airport d;
+    CHECK(decoder.decode(view("{\"id\": \"580\", \"active\": 1}"), d));
+    CHECK(d.id == -1);
+    CHECK(!d.active);
+
+    CHECK(!decoder.decode(view("[1, 2]"), d));
+    CHECK(!decoder.decode(view("\"str\""), d));
+}
+
+static void
+test_borrowed()
+{
+    std::string row = "{\"name\": \"raw\\n\", \"extra\": [1, {\"a\": 2}]}";
+    RowDecoder<Borrowed> decoder;
+    Borrowed b;
+    CHECK(decoder.decode(view(row), b));
+
+    // Buffers are not unescaped, and point into the row
+    CHECK(b.name.to_string() == "raw\\n");
+    CHECK(b.name.data() > row.data() && b.name.data() < row.data() + row.size());
+    CHECK(b.extra.size() == 2);
+    CHECK(b.extra[1]["a"].as_int() == 2);
+}
+
+int main(int, char**)
+{
+    test_decode();
+    test_borrowed();
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <libcouchbase/couchbase++.h>
+#include <libcouchbase/couchbase++/row_common.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include "check.h"
+#include "counting_resource.h"
+
+using namespace Couchbase;
+using Internal::RowRing;
+using Internal::RowSlab;
+using Internal::RowProvider;
+
+static bool
+same_owner(const std::shared_ptr<char>& a, const std::shared_ptr<char>& b)
+{
+    return !a.owner_before(b) && !b.owner_before(a);
+}
+
+static void
+test_ring_order()
+{
+    RowRing<std::unique_ptr<int>> ring;
+    CHECK(ring.empty());
+
+    // Interleave pushes and pops so that the ring wraps around before it
+    // has to grow, and check that growing preserves FIFO order
+    int pushed = 0, popped = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int ii = 0; ii < 7; ii++) {
+            ring.push_back(std::unique_ptr<int>(new int(pushed++)));
+        }
+        for (int ii = 0; ii < 3; ii++) {
+            CHECK(*ring.front() == popped++);
+            ring.pop_front();
+        }
+        CHECK(ring.size() == size_t(pushed - popped));
+    }
+    while (!ring.empty()) {
+        CHECK(*ring.front() == popped++);
+        ring.pop_front();
+    }
+    CHECK(popped == pushed);
+}
+
+static void
+test_ring_destroy()
+{
+    std::shared_ptr<int> held(new int(1));
+    {
+        RowRing<std::shared_ptr<int>> ring;
+        for (int ii = 0; ii < 20; ii++) {
+            ring.push_back(std::shared_ptr<int>(held));
+        }
+        ring.pop_front();
+        CHECK(held.use_count() == 20);
+    }
+    // Rows still buffered are destroyed with the ring
+    CHECK(held.use_count() == 1);
+}
+
+static void
+test_slab()
+{
+    CountingResource resource;
+    {
+        RowSlab slab(1024);
+        std::shared_ptr<char> a = slab.allocate(&resource, 100);
+        std::shared_ptr<char> b = slab.allocate(&resource, 100);
+
+        // Small rows are packed next to each other in one slab
+        CHECK(b.get() == a.get() + 100);
+        CHECK(same_owner(a, b));
+        size_t nslab = resource.live;
+
+        // Rows larger than a quarter of a slab get their own buffer
+        std::shared_ptr<char> big = slab.allocate(&resource, 300);
+        CHECK(!same_owner(big, a));
+        CHECK(resource.live > nslab);
+        big.reset();
+        CHECK(resource.live == nslab);
+
+        // ... and do not use up room in the current slab
+        std::shared_ptr<char> c = slab.allocate(&resource, 200);
+        CHECK(c.get() == b.get() + 100);
+
+        // A full slab is replaced by a new one
+        std::shared_ptr<char> d = slab.allocate(&resource, 250);
+        CHECK(same_owner(d, a));
+        std::shared_ptr<char> e = slab.allocate(&resource, 250);
+        CHECK(same_owner(e, a));
+        e = slab.allocate(&resource, 250);
+        CHECK(!same_owner(e, a));
+
+        // Switching resources starts a new slab from the new resource
+        CountingResource other;
+        std::shared_ptr<char> f = slab.allocate(&other, 10);
+        CHECK(!same_owner(f, e));
+        CHECK(other.live != 0);
+        f.reset();
+        slab.allocate(&resource, 10);
+        CHECK(other.live == 0);
+
+        // A slab outlives the RowSlab for as long as rows refer to it
+        a.reset();
+        b.reset();
+        c.reset();
+        d.reset();
+        e.reset();
+        CHECK(resource.live != 0);
+    }
+    CHECK(resource.live == 0);
+}
+
+static void
+test_slab_rows_outlive()
+{
+    CountingResource resource;
+    std::shared_ptr<char> row;
+    {
+        RowSlab slab(1024);
+        row = slab.allocate(&resource, 10);
+        slab.allocate(&resource, 10);
+    }
+    CHECK(resource.live != 0);
+    row.reset();
+    CHECK(resource.live == 0);
+}
+
+// Provider whose rows are strings, and which delivers the next pending
+// row each time it waits for more
+class StringProvider : public RowProvider<std::string> {
+public:
+    using RowProvider::rp_add;
+    using RowProvider::rp_full;
+    using RowProvider::rp_begin;
+    using RowProvider::rp_end;
+    std::deque<std::string> pending;
+    size_t waits = 0;
+
+protected:
+    bool rp_active() const override { return !pending.empty(); }
+    void rp_wait() override {
+        waits++;
+        rp_add(std::move(pending.front()));
+        pending.pop_front();
+    }
+    size_t rp_size(const std::string& row) const override { return row.size(); }
+};
+
+static void
+test_provider_limits()
+{
+    StringProvider unlimited;
+    for (int ii = 0; ii < 100; ii++) {
+        CHECK(!unlimited.rp_add("row"));
+    }
+    CHECK(unlimited.rows_buffered() == 100);
+    CHECK(unlimited.bytes_buffered() == 300);
+    CHECK(!unlimited.rp_full(1000, 1000));
+
+    StringProvider rows;
+    rows.buffer_limit(3);
+    CHECK(!rows.rp_add("a"));
+    // Rows held elsewhere (such as QueryGroup's merge queues) count too
+    CHECK(!rows.rp_full(1, 100));
+    CHECK(rows.rp_full(2, 0));
+    CHECK(!rows.rp_add("b"));
+    CHECK(rows.rp_add("c"));
+    CHECK(rows.rp_full(0, 0));
+
+    StringProvider bytes;
+    bytes.buffer_limit(0, 10);
+    CHECK(!bytes.rp_add("aaaa"));
+    CHECK(!bytes.rp_full(100, 5));
+    CHECK(bytes.rp_full(0, 6));
+    CHECK(bytes.rp_add("bbbbbb"));
+    CHECK(bytes.bytes_buffered() == 10);
+}
+
+static void
+test_provider_iterate()
+{
+    StringProvider provider;
+    provider.buffer_limit(2);
+    provider.rp_add("one");
+    provider.pending.push_back("two");
+    provider.pending.push_back("three");
+
+    const char *expected[] = { "one", "two", "three" };
+    size_t ix = 0;
+    for (auto ii = provider.rp_begin(); ii != provider.rp_end(); ++ii) {
+        CHECK(*ii == expected[ix++]);
+        CHECK(provider.rows_buffered() == 1);
+        CHECK(provider.bytes_buffered() == ii->size());
+    }
+    CHECK(ix == 3);
+    CHECK(provider.waits == 2);
+
+    // Consumed rows no longer count against the limits
+    CHECK(provider.rows_buffered() == 0);
+    CHECK(provider.bytes_buffered() == 0);
+    CHECK(!provider.rp_full(1, 0));
+}
+
+int main(int, char**)
+{
+    test_ring_order();
+    test_ring_destroy();
+    test_slab();
+    test_slab_rows_outlive();
+    test_provider_limits();
+    test_provider_iterate();
+    return 0;
+}
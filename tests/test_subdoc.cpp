@@ -0,0 +1,149 @@
+#include <libcouchbase/couchbase++.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "responses.h"
+
+using namespace Couchbase;
+
+// Stands in for the library's parser: the response's `responses` field
+// points to an array of `nres` ready-made entries
+extern "C" int
+lcb_sdresult_next(const lcb_RESPSUBDOC *resp, lcb_SDENTRY *ent, size_t *iter)
+{
+    if (*iter >= resp->nres) {
+        return 0;
+    }
+    *ent = static_cast<const lcb_SDENTRY*>(resp->responses)[(*iter)++];
+    return 1;
+}
+
+static lcb_SDENTRY
+entry(lcb_U8 index, lcb_error_t status, const char *value = "")
+{
+    lcb_SDENTRY ent;
+    memset(&ent, 0, sizeof ent);
+    ent.index = index;
+    ent.status = status;
+    ent.value = value;
+    ent.nvalue = strlen(value);
+    return ent;
+}
+
+template <typename T> static void
+respond(T& resp, int cbtype, lcb_error_t rc, const std::vector<lcb_SDENTRY>& entries)
+{
+    lcb_RESPSUBDOC raw;
+    memset(&raw, 0, sizeof raw);
+    raw.rc = rc;
+    raw.responses = entries.data();
+    raw.nres = entries.size();
+    resp.handle_response(test_client(), cbtype, reinterpret_cast<lcb_RESPBASE*>(&raw));
+}
+
+static std::string
+path(const lcb_SDSPEC& spec)
+{
+    return std::string(static_cast<const char*>(spec.path.contig.bytes), spec.path.contig.nbytes);
+}
+
+static std::string
+value(const lcb_SDSPEC& spec)
+{
+    return std::string(static_cast<const char*>(spec.value.u_buf.contig.bytes),
+        spec.value.u_buf.contig.nbytes);
+}
+
+static void
+test_commands()
+{
+    // Paths and values given as temporaries are kept by the command ...
+    LookupInCommand lookup("key");
+    lookup.get(std::string("a.b")).exists(std::string("c")).get_count(std::string("d[0]"));
+    MutateInCommand mutate("key");
+    mutate.upsert(std::string("x"), std::string("\"1\""))
+        .remove(std::string("y"))
+        .counter(std::string("z"), -5);
+
+    // ... and by its copies, after the original is gone
+    LookupInCommand *orig = new LookupInCommand(lookup);
+    LookupInCommand copy(*orig);
+    delete orig;
+
+    CHECK(copy.size() == 3);
+    CHECK((&copy)->nspecs == 3);
+    CHECK(path((&copy)->specs[0]) == "a.b");
+    CHECK(path((&copy)->specs[1]) == "c");
+    CHECK(path((&copy)->specs[2]) == "d[0]");
+
+    CHECK((&mutate)->nspecs == 3);
+    CHECK(path((&mutate)->specs[0]) == "x");
+    CHECK(value((&mutate)->specs[0]) == "\"1\"");
+    CHECK(path((&mutate)->specs[1]) == "y");
+    CHECK(path((&mutate)->specs[2]) == "z");
+    CHECK(value((&mutate)->specs[2]) == "-5");
+}
+
+static void
+test_results()
+{
+    // Lookups have an entry per path
+    LookupInResponse lookup;
+    respond(lookup, LCB_CALLBACK_SDLOOKUP, LCB_SUBDOC_MULTI_FAILURE, {
+        entry(0, LCB_SUCCESS, "\"v\""), entry(1, LCB_SUBDOC_PATH_ENOENT)
+    });
+    CHECK(lookup.size() == 2);
+    CHECK(lookup.status(0).success());
+    CHECK(lookup.value(0).to_string() == "\"v\"");
+    CHECK(!lookup.exists(1));
+    CHECK(lookup.status(2).errcode() == LCB_EINVAL);
+
+    // Successful mutations only have entries for paths with a value; the
+    // others succeeded too
+    Internal::SubdocResults results;
+    results.expect(3);
+    lcb_SDENTRY counter = entry(1, LCB_SUCCESS, "42");
+    lcb_RESPSUBDOC raw;
+    memset(&raw, 0, sizeof raw);
+    raw.rc = LCB_SUCCESS;
+    raw.responses = &counter;
+    raw.nres = 1;
+    results.load(&raw);
+    CHECK(results.size() == 2);
+    CHECK(results.status(0).success());
+    CHECK(results.status(1).success());
+    CHECK(results.value(1).to_string() == "42");
+    CHECK(results.status(2).success());
+    CHECK(results.status(3).errcode() == LCB_EINVAL);
+
+    // ... but not if the mutation failed
+    lcb_SDENTRY failed = entry(0, LCB_SUBDOC_PATH_EEXISTS);
+    raw.rc = LCB_SUBDOC_MULTI_FAILURE;
+    raw.responses = &failed;
+    raw.nres = 1;
+    results.load(&raw);
+    CHECK(results.status(0).errcode() == LCB_SUBDOC_PATH_EEXISTS);
+    CHECK(results.status(1).errcode() == LCB_EINVAL);
+
+    // Copies keep the spec count
+    Internal::SubdocResults copy(results);
+    CHECK(copy.status(2).errcode() == LCB_EINVAL);
+    raw.rc = LCB_SUCCESS;
+    raw.nres = 0;
+    copy.load(&raw);
+    CHECK(copy.status(2).success());
+
+    // Without a spec count, only paths with entries are known
+    MutateInResponse mutate;
+    respond(mutate, LCB_CALLBACK_SDMUTATE, LCB_SUCCESS, { entry(1, LCB_SUCCESS, "7") });
+    CHECK(mutate.status(1).success());
+    CHECK(mutate.status(2).errcode() == LCB_EINVAL);
+}
+
+int main(int, char**)
+{
+    test_commands();
+    test_results();
+    return 0;
+}